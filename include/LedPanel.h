@@ -2,6 +2,8 @@
 
 #include <MD_MAX72xx.h>
 
+class PanelChains;
+
 // Graphics library for MD_MAX72XX
 // E.g. for 4 devices
 // [3][2][1][0] <= Microcontroller
@@ -22,6 +24,10 @@ private:
     uint8_t devicesHigh;  // Number of devices in the vertical direction
     uint16_t pixelWidth;  // Total display width in pixels
     uint16_t pixelHeight; // Total display height in pixels
+    PanelChains *chains;  // Drives the modules instead of mx when set
+    bool inFrame;
+
+    void invert();
 
 public:
     uint16_t width() const { return pixelWidth; }
@@ -29,15 +35,26 @@ public:
 
     // Constructor accepts the matrix object and device arrangement
     LedPanel(MD_MAX72XX &matrix, uint8_t devWide, uint8_t devHigh)
-        : mx(matrix), devicesWide(devWide), devicesHigh(devHigh)
+        : mx(matrix), devicesWide(devWide), devicesHigh(devHigh), chains(nullptr), inFrame(false)
     {
         pixelWidth = devicesWide * 8;
         pixelHeight = devicesHigh * 8;
     }
 
+    // Send to the modules through several chains instead (PanelChains.h);
+    // module indices are the same as in mx's single chain
+    void setOutput(PanelChains *out) { chains = out; }
+
     // Basic graphical functions
+    void clear();
+    void setIntensity(uint8_t intensity);
     void drawPoint(int x, int y, bool on);
     void drawLine(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
+    // Eight pixels of row y at once, bit n being x = moduleX * 8 + n
+    void drawDeviceRow(int moduleX, int y, uint8_t bits);
+    // Hold drawing back, then send it in one go
+    void beginFrame();
+    void endFrame();
 
     // More advanced graphics functions
    
@@ -1,4 +1,25 @@
 #include "LedPanel.h"
+#include "PanelChains.h"
+
+void LedPanel::clear()
+{
+  if (!chains)
+  {
+    mx.clear();
+    return;
+  }
+  chains->clear();
+  if (!inFrame)
+    chains->flush();
+}
+
+void LedPanel::setIntensity(uint8_t intensity)
+{
+  if (chains)
+    chains->setIntensity(intensity);
+  else
+    mx.control(MD_MAX72XX::INTENSITY, intensity);
+}
 
 void LedPanel::drawPoint(int x, int y, bool on)
 {
@@ -26,6 +47,17 @@ void LedPanel::drawPoint(int x, int y, bool on)
   // Adjust if your modules are arranged differently
   int moduleIndex = (devicesHigh - 1 - moduleY) * devicesWide + (devicesWide - 1 - moduleX);
 
+  if (chains)
+  {
+    // FC16 register data has the columns the other way round to mx's
+    uint8_t row = chains->getRow(moduleIndex, localY);
+    uint8_t bit = 1 << (7 - localX);
+    chains->setRow(moduleIndex, localY, on ? row | bit : row & ~bit);
+    if (!inFrame)
+      chains->flush();
+    return;
+  }
+
   // Calculate the column index in the overall display
   int columnIndex = moduleIndex * 8 + localX;
 
@@ -33,6 +65,49 @@ void LedPanel::drawPoint(int x, int y, bool on)
   mx.setPoint(localY, columnIndex, on);
 }
 
+void LedPanel::drawDeviceRow(int moduleX, int y, uint8_t bits)
+{
+  if (moduleX < 0 || moduleX >= devicesWide || y < 0 || y >= pixelHeight)
+    return;
+
+  int moduleIndex = (devicesHigh - 1 - y / 8) * devicesWide + (devicesWide - 1 - moduleX);
+  if (chains)
+  {
+    // The chains take the register value, which is not reversed
+    chains->setRow(moduleIndex, 7 - y % 8, bits);
+    if (!inFrame)
+      chains->flush();
+    return;
+  }
+
+  // Same mapping as drawPoint(): columns are reversed within a module, so
+  // bit n of the device row is x = 7 - n
+  uint8_t reversed = 0;
+  for (int i = 0; i < 8; i++)
+    reversed |= ((bits >> i) & 1) << (7 - i);
+  mx.setRow(moduleIndex, 7 - y % 8, reversed);
+}
+
+void LedPanel::beginFrame()
+{
+  inFrame = true;
+  if (chains)
+    return;
+  mx.control(MD_MAX72XX::UPDATE, MD_MAX72XX::OFF);
+}
+
+void LedPanel::endFrame()
+{
+  inFrame = false;
+  if (chains)
+  {
+    chains->flush();
+    return;
+  }
+  mx.update();
+  mx.control(MD_MAX72XX::UPDATE, MD_MAX72XX::ON);
+}
+
 void LedPanel::drawLine(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
 {
   int dx = abs(x1 - x0);
@@ -71,7 +146,8 @@ void LedPanel::spiral(bool inward)
          (!inward && left >= -1 && right < pixelWidth + 1 &&
           top >= -1 && bottom < pixelHeight + 1))
   {
-    mx.clear();
+    beginFrame();
+    clear();
     // Draw current spiral frame
     for (int i = left; i <= right; i++)
       drawPoint(i, inward ? top : bottom, true);
@@ -81,6 +157,7 @@ void LedPanel::spiral(bool inward)
       drawPoint(i, inward ? bottom : top, true);
     for (int i = bottom; i >= top; i--)
       drawPoint(inward ? left : right, i, true);
+    endFrame();
 
     delay(100);
 
@@ -108,7 +185,8 @@ void LedPanel::wave()
 
   for (int radius = 0; radius <= max(pixelWidth, pixelHeight); radius++)
   {
-    mx.clear();
+    beginFrame();
+    clear();
     for (int y = 0; y < pixelHeight; y++)
     {
       for (int x = 0; x < pixelWidth; x++)
@@ -118,18 +196,35 @@ void LedPanel::wave()
         drawPoint(x, y, (int)distance == radius);
       }
     }
+    endFrame();
     delay(100);
   }
 }
 
+// Every pixel on the modules flipped, through whichever output drives them
+void LedPanel::invert()
+{
+  if (!chains)
+  {
+    mx.transform(MD_MAX72XX::TINV);
+    return;
+  }
+  for (int m = 0; m < chains->getModuleCount(); m++)
+  {
+    for (int d = 0; d < 8; d++)
+      chains->setRow(m, d, ~chains->getRow(m, d));
+  }
+  chains->flush();
+}
+
 void LedPanel::flash()
 {
   // Blink current pattern 3 times
   for (int i = 0; i < 3; i++)
   {
-    mx.transform(MD_MAX72XX::TINV);
+    invert();
     delay(200);
-    mx.transform(MD_MAX72XX::TINV);
+    invert();
     delay(200);
   }
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "LifeArena.h"
+#include <stdlib.h>
+
+#if LIFE_STATIC_MEMORY
+#include <mutex>
+
+// Each block starts with the offset of the block before it and whether it
+// has been freed
+struct BlockHeader
+{
+    uint32_t previous;
+    uint32_t freed;
+};
+
+static const uint32_t NO_BLOCK = 0xFFFFFFFF;
+
+static uint8_t *arenaBase = nullptr;
+static size_t arenaSize = 0;
+static size_t arenaTop = 0;
+static size_t arenaPeak = 0;
+static uint32_t lastBlock = NO_BLOCK;
+static uint32_t failed = 0;
+static std::mutex arenaLock; // The soup screener allocates from the other core
+
+LifeArena::LifeArena(void *memory, size_t bytes)
+{
+    std::lock_guard<std::mutex> guard(arenaLock);
+    // Blocks are 8-byte aligned
+    size_t skip = (8 - ((uintptr_t)memory & 7)) & 7;
+    arenaBase = (uint8_t *)memory + skip;
+    arenaSize = bytes > skip ? (bytes - skip) & ~(size_t)7 : 0;
+    arenaTop = arenaPeak = 0;
+    lastBlock = NO_BLOCK;
+}
+
+void *lifeAlloc(size_t bytes)
+{
+    std::lock_guard<std::mutex> guard(arenaLock);
+    size_t need = LifeArena::blockBytes(bytes);
+    if (!arenaBase || need > arenaSize - arenaTop)
+    {
+        failed++;
+        return nullptr;
+    }
+    BlockHeader *h = (BlockHeader *)(arenaBase + arenaTop);
+    h->previous = lastBlock;
+    h->freed = 0;
+    lastBlock = arenaTop;
+    arenaTop += need;
+    if (arenaTop > arenaPeak)
+        arenaPeak = arenaTop;
+    return h + 1;
+}
+
+void lifeFree(void *p)
+{
+    if (!p)
+        return;
+    std::lock_guard<std::mutex> guard(arenaLock);
+    ((BlockHeader *)p - 1)->freed = 1;
+    while (lastBlock != NO_BLOCK && ((BlockHeader *)(arenaBase + lastBlock))->freed)
+    {
+        arenaTop = lastBlock;
+        lastBlock = ((BlockHeader *)(arenaBase + lastBlock))->previous;
+    }
+}
+
+size_t LifeArena::capacity() { return arenaSize; }
+size_t LifeArena::used() { return arenaTop; }
+size_t LifeArena::peak() { return arenaPeak; }
+uint32_t LifeArena::failures() { return failed; }
+
+#else
+
+LifeArena::LifeArena(void *, size_t) {}
+
+void *lifeAlloc(size_t bytes)
+{
+    return malloc(bytes);
+}
+
+void lifeFree(void *p)
+{
+    free(p);
+}
+
+size_t LifeArena::capacity() { return 0; }
+size_t LifeArena::used() { return 0; }
+size_t LifeArena::peak() { return 0; }
+uint32_t LifeArena::failures() { return 0; }
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+// Heap-free builds (-DLIFE_STATIC_MEMORY=1) take the engine, recorder,
+// snapshot and server buffers from one fixed arena, sized at compile time
+// and registered by constructing a LifeArena before anything allocates.
+// Otherwise lifeAlloc() is plain malloc().
+//
+// The arena is a stack: lifeFree() of the newest block gives it back,
+// along with any older blocks already freed beneath it. Long-lived buffers
+// are allocated once at start up; temporaries (a snapshot being saved, a
+// replay) are freed in reverse order, so the arena never fragments.
+#ifndef LIFE_STATIC_MEMORY
+#define LIFE_STATIC_MEMORY 0
+#endif
+
+// nullptr when the arena is full
+void *lifeAlloc(size_t bytes);
+void lifeFree(void *p);
+
+class LifeArena
+{
+public:
+    // What one allocation of `bytes` takes from the arena
+    static constexpr size_t blockBytes(size_t bytes) { return 8 + ((bytes + 7) & ~(size_t)7); }
+
+    LifeArena(void *memory, size_t bytes);
+
+    static size_t capacity();
+    static size_t used();
+    static size_t peak();
+    static uint32_t failures(); // lifeAlloc() calls the arena could not satisfy
+};
+
+#if LIFE_STATIC_MEMORY
+template <typename T>
+struct LifeAllocator
+{
+    typedef T value_type;
+
+    LifeAllocator() {}
+    template <typename U>
+    LifeAllocator(const LifeAllocator<U> &) {}
+
+    // An arena too small for the build is fatal, like running out of heap
+    T *allocate(size_t n)
+    {
+        T *p = static_cast<T *>(lifeAlloc(n * sizeof(T)));
+        if (!p)
+            abort();
+        return p;
+    }
+    void deallocate(T *p, size_t) { lifeFree(p); }
+};
+
+template <typename T, typename U>
+bool operator==(const LifeAllocator<T> &, const LifeAllocator<U> &) { return true; }
+template <typename T, typename U>
+bool operator!=(const LifeAllocator<T> &, const LifeAllocator<U> &) { return false; }
+
+// Reserve the largest size a LifeVector will reach, so it never reallocates
+template <typename T>
+using LifeVector = std::vector<T, LifeAllocator<T>>;
+#else
+template <typename T>
+using LifeVector = std::vector<T>;
+#endif
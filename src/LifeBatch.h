@@ -0,0 +1,315 @@
+#pragma once
+#include <stdint.h>
+#include "life.h"
+
+// Steps up to 32 (uint32_t) or 64 (uint64_t) independent boards at once.
+// The boards are stored transposed: each word holds the same cell across
+// all boards, bit N belonging to board ("lane") N, so one bitwise kernel
+// advances every board. Rules, wrap behaviour, generation limit and the
+// static/oscillation checks match GameOfLife exactly, per lane.
+template <typename Word>
+class LifeBatch
+{
+public:
+    static const int LANES = sizeof(Word) * 8;
+
+    // Arena space (LIFE_STATIC_MEMORY) for a batch of w x h boards
+    static constexpr size_t arenaBytes(int w, int h)
+    {
+        return 2 * LifeArena::blockBytes((size_t)w * h * sizeof(Word)) +
+               LifeArena::blockBytes((size_t)w * h * sizeof(unsigned long));
+    }
+
+    LifeBatch(int w, int h, bool wrap = true, unsigned int maxGen = 180)
+        : width(w), height(h), wrapAround(wrap), maxGenerations(maxGen),
+          cells(w * h), nextCells(w * h), pow33(w * h)
+    {
+        // djb2 is linear, so a board hash is a constant plus one power of 33
+        // per live cell. This lets each lane be hashed from its live cells only.
+        unsigned long p = 1;
+        for (int i = w * h - 1; i >= 0; i--)
+        {
+            pow33[i] = p;
+            p *= 33;
+        }
+        hashBase = 5381 * p;
+        clear();
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    unsigned int getMaxGenerations() const { return maxGenerations; }
+
+    void clear()
+    {
+        for (int i = 0; i < width * height; i++)
+            cells[i] = 0;
+        active = 0;
+        for (int l = 0; l < LANES; l++)
+            resetLane(l);
+    }
+
+    bool getCell(int lane, int x, int y) const
+    {
+        if (!wrapAround && (x < 0 || x >= width || y < 0 || y >= height))
+            return false;
+        return (cells[getIndex(x, y)] >> lane) & 1;
+    }
+
+    void setCell(int lane, int x, int y, bool state)
+    {
+        if (x < 0 || x >= width || y < 0 || y >= height)
+            return;
+        Word bit = (Word)1 << lane;
+        Word &c = cells[getIndex(x, y)];
+        c = state ? (c | bit) : (c & ~bit);
+    }
+
+    // Same soup as GameOfLife::randomize(seed); the lane becomes active
+    void randomize(int lane, uint32_t seed)
+    {
+        uint32_t x = seed ? seed : 0x9E3779B9;
+        for (int i = 0; i < width * height; i++)
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            Word bit = (Word)1 << lane;
+            cells[i] = (x >> 31) ? (cells[i] | bit) : (cells[i] & ~bit);
+        }
+        resetLane(lane);
+        active |= (Word)1 << lane;
+    }
+
+    void loadBoard(int lane, const GameOfLife &game)
+    {
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                setCell(lane, x, y, game.getCell(x, y));
+        resetLane(lane);
+        active |= (Word)1 << lane;
+    }
+
+    void storeBoard(int lane, GameOfLife &game) const
+    {
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                game.setCell(x, y, getCell(lane, x, y));
+    }
+
+    // Lanes still running (not yet finished)
+    Word getActive() const { return active; }
+    unsigned int getGenerationCount(int lane) const { return generations[lane]; }
+    unsigned int getFinalPeriod(int lane) const { return finalPeriod[lane]; }
+
+    // One computeNextGeneration() for every lane, finished or not
+    void step()
+    {
+        computeNext();
+        cells.swap(nextCells);
+    }
+
+    // One isGameFinished()/computeNextGeneration() round for every active
+    // lane. Lanes that finish keep their final board. Returns the lanes
+    // still active.
+    Word advance()
+    {
+        Word changed = computeNext();
+
+        Word stepping = active;
+        for (int l = 0; l < LANES; l++)
+        {
+            Word bit = (Word)1 << l;
+            if (!(active & bit))
+                continue;
+
+            if (generations[l] >= maxGenerations)
+                finish(l, 0);
+            else if (!(changed & bit))
+                finish(l, 1);
+        }
+        stepping &= active;
+
+        // Oscillation check on the lanes that are still moving
+        if (stepping)
+        {
+            unsigned long hashes[LANES];
+            hashLanes(stepping, hashes);
+            for (int l = 0; l < LANES; l++)
+            {
+                if (!(stepping & ((Word)1 << l)))
+                    continue;
+                if (checkHistory(l, hashes[l]))
+                    stepping &= ~((Word)1 << l);
+            }
+        }
+
+        for (int i = 0; i < width * height; i++)
+            cells[i] = (nextCells[i] & stepping) | (cells[i] & ~stepping);
+        for (int l = 0; l < LANES; l++)
+        {
+            if (stepping & ((Word)1 << l))
+                generations[l]++;
+        }
+        return active;
+    }
+
+    // Live cells per lane, counted bit-sliced across the whole board
+    void getPopulations(int *out) const
+    {
+        // planes[b] holds bit b of every lane's running count
+        Word planes[32] = {};
+        int bits = 0;
+        for (int i = 0; i < width * height; i++)
+        {
+            Word carry = cells[i];
+            for (int b = 0; carry; b++)
+            {
+                Word sum = planes[b] ^ carry;
+                carry &= planes[b];
+                planes[b] = sum;
+                if (b >= bits)
+                    bits = b + 1;
+            }
+        }
+        for (int l = 0; l < LANES; l++)
+        {
+            int count = 0;
+            for (int b = 0; b < bits; b++)
+                count |= (int)((planes[b] >> l) & 1) << b;
+            out[l] = count;
+        }
+    }
+
+    unsigned long calculateBoardHash(int lane) const
+    {
+        unsigned long hashes[LANES];
+        hashLanes((Word)1 << lane, hashes);
+        return hashes[lane];
+    }
+
+private:
+    int width;
+    int height;
+    bool wrapAround;
+    unsigned int maxGenerations;
+    LifeVector<Word> cells;
+    LifeVector<Word> nextCells;
+    LifeVector<unsigned long> pow33;
+    unsigned long hashBase;
+    Word active;
+
+    unsigned int generations[LANES];
+    unsigned int finalPeriod[LANES];
+    unsigned long history[LANES][GameOfLife::HISTORY_SIZE];
+    int historySize[LANES];
+    int historyHead[LANES]; // Next slot to write
+
+    int getIndex(int x, int y) const
+    {
+        if (wrapAround)
+        {
+            x = (x + width) % width;
+            y = (y + height) % height;
+        }
+        return y * width + x;
+    }
+
+    void resetLane(int l)
+    {
+        generations[l] = 0;
+        finalPeriod[l] = 0;
+        historySize[l] = 0;
+        historyHead[l] = 0;
+    }
+
+    void finish(int l, unsigned int period)
+    {
+        finalPeriod[l] = period;
+        historySize[l] = 0;
+        historyHead[l] = 0;
+        active &= ~((Word)1 << l);
+    }
+
+    // True (and the lane finished) if the hash repeats a recent board
+    bool checkHistory(int l, unsigned long hash)
+    {
+        for (int age = 1; age <= historySize[l]; age++)
+        {
+            int slot = (historyHead[l] - age + GameOfLife::HISTORY_SIZE) % GameOfLife::HISTORY_SIZE;
+            if (history[l][slot] == hash)
+            {
+                finish(l, age);
+                return true;
+            }
+        }
+        history[l][historyHead[l]] = hash;
+        historyHead[l] = (historyHead[l] + 1) % GameOfLife::HISTORY_SIZE;
+        if (historySize[l] < GameOfLife::HISTORY_SIZE)
+            historySize[l]++;
+        return false;
+    }
+
+    void hashLanes(Word lanes, unsigned long *hashes) const
+    {
+        for (int l = 0; l < LANES; l++)
+            hashes[l] = hashBase;
+        for (int i = 0; i < width * height; i++)
+        {
+            Word live = cells[i] & lanes;
+            while (live)
+            {
+                int l = lowestBit(live);
+                hashes[l] += pow33[i];
+                live &= live - 1;
+            }
+        }
+    }
+
+    static int lowestBit(Word w)
+    {
+        if (sizeof(Word) > sizeof(unsigned int))
+            return __builtin_ctzll((unsigned long long)w);
+        return __builtin_ctz((unsigned int)w);
+    }
+
+    // Bit-sliced B3/S23 over all lanes; returns the lanes that changed
+    Word computeNext()
+    {
+        Word changed = 0;
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                // Counter bits: s2 saturates once four or more neighbours are seen
+                Word s0 = 0, s1 = 0, s2 = 0;
+                for (int dy = -1; dy <= 1; dy++)
+                {
+                    for (int dx = -1; dx <= 1; dx++)
+                    {
+                        if (dx == 0 && dy == 0)
+                            continue;
+                        Word n = neighbour(x + dx, y + dy);
+                        Word c0 = s0 & n;
+                        s0 ^= n;
+                        Word c1 = s1 & c0;
+                        s1 ^= c0;
+                        s2 |= c1;
+                    }
+                }
+                Word cur = cells[y * width + x];
+                Word next = ~s2 & s1 & (s0 | cur);
+                nextCells[y * width + x] = next;
+                changed |= next ^ cur;
+            }
+        }
+        return changed;
+    }
+
+    Word neighbour(int x, int y) const
+    {
+        if (!wrapAround && (x < 0 || x >= width || y < 0 || y >= height))
+            return 0;
+        return cells[getIndex(x, y)];
+    }
+};
@@ -0,0 +1,149 @@
+#include "LifeKernel.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LIFE_KERNEL_X86 1
+typedef uint64_t v2u64 __attribute__((vector_size(16)));
+typedef uint64_t v4u64 __attribute__((vector_size(32)));
+#else
+#define LIFE_KERNEL_X86 0
+#endif
+
+#define LIFE_INLINE static inline __attribute__((always_inline))
+
+// Vectors only pass by reference so the helpers have no vector ABI of
+// their own; they are always inlined into the kernel that targets the ISA.
+template <typename V>
+LIFE_INLINE void load(V &v, const uint64_t *p)
+{
+    memcpy(&v, p, sizeof(v));
+}
+
+// The cells to the west and east of each cell in words p[0..n), n = lanes
+template <typename V>
+LIFE_INLINE void westEast(const uint64_t *p, V &w, V &c, V &e)
+{
+    V before, after;
+    load(c, p);
+    load(before, p - 1);
+    load(after, p + 1);
+    w = (c << 1) | (before >> 63);
+    e = (c >> 1) | (after << 63);
+}
+
+// B3/S23 on 64 cells per lane.
+// With at most eight neighbours, a cell lives next time exactly when its
+// neighbour count written as ones + 2 * twos has exactly one "two": the
+// total is then 2 (survives if alive) or 3 (always alive).
+template <typename V>
+LIFE_INLINE void lifeWord(const uint64_t *up, const uint64_t *mid, const uint64_t *down, uint64_t *out)
+{
+    V uw, u, ue, w, c, e, dw, d, de;
+    westEast(up, uw, u, ue);
+    westEast(mid, w, c, e);
+    westEast(down, dw, d, de);
+
+    // Column sums: three cells above and below, two beside
+    V us = uw ^ u ^ ue, uc = (uw & u) | (ue & (uw ^ u));
+    V ds = dw ^ d ^ de, dc = (dw & d) | (de & (dw ^ d));
+    V ms = w ^ e, mc = w & e;
+
+    V ones = us ^ ds ^ ms;
+    V twoFromOnes = (us & ds) | (ms & (us ^ ds));
+
+    V orA = uc | dc, andA = uc & dc;
+    V orB = mc | twoFromOnes, andB = mc & twoFromOnes;
+    V next = (orA ^ orB) & ~andA & ~andB & (ones | c);
+    memcpy(out, &next, sizeof(next));
+}
+
+static void rowPortable(const uint64_t *up, const uint64_t *mid,
+                        const uint64_t *down, uint64_t *out, int words)
+{
+    for (int i = 0; i < words; i++)
+        lifeWord<uint64_t>(up + i, mid + i, down + i, out + i);
+}
+
+#if LIFE_KERNEL_X86
+__attribute__((target("sse2"))) static void rowSse2(const uint64_t *up, const uint64_t *mid,
+                                                    const uint64_t *down, uint64_t *out, int words)
+{
+    int i = 0;
+    for (; i + 2 <= words; i += 2)
+        lifeWord<v2u64>(up + i, mid + i, down + i, out + i);
+    for (; i < words; i++)
+        lifeWord<uint64_t>(up + i, mid + i, down + i, out + i);
+}
+
+__attribute__((target("avx2"))) static void rowAvx2(const uint64_t *up, const uint64_t *mid,
+                                                    const uint64_t *down, uint64_t *out, int words)
+{
+    int i = 0;
+    for (; i + 4 <= words; i += 4)
+        lifeWord<v4u64>(up + i, mid + i, down + i, out + i);
+    for (; i < words; i++)
+        lifeWord<uint64_t>(up + i, mid + i, down + i, out + i);
+}
+#endif
+
+bool lifeKernelSupported(LifeKernelType type)
+{
+    switch (type)
+    {
+    case KERNEL_PORTABLE:
+        return true;
+#if LIFE_KERNEL_X86
+    case KERNEL_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+LifeKernelType lifeBestKernel()
+{
+    // Worked out once; a local static is safe against boards set up on
+    // several threads at once
+    static const LifeKernelType best = []()
+    {
+        if (lifeKernelSupported(KERNEL_AVX2))
+            return KERNEL_AVX2;
+        if (lifeKernelSupported(KERNEL_SSE2))
+            return KERNEL_SSE2;
+        return KERNEL_PORTABLE;
+    }();
+    return best;
+}
+
+LifeRowKernel lifeRowKernel(LifeKernelType type)
+{
+    if (!lifeKernelSupported(type))
+        return rowPortable;
+    switch (type)
+    {
+#if LIFE_KERNEL_X86
+    case KERNEL_SSE2:
+        return rowSse2;
+    case KERNEL_AVX2:
+        return rowAvx2;
+#endif
+    default:
+        return rowPortable;
+    }
+}
+
+const char *lifeKernelName(LifeKernelType type)
+{
+    switch (type)
+    {
+    case KERNEL_SSE2:
+        return "sse2";
+    case KERNEL_AVX2:
+        return "avx2";
+    default:
+        return "portable";
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+
+// B3/S23 row kernels for boards packed 64 cells to a uint64_t, bit 0 of
+// word 0 being the leftmost cell.
+//
+// A kernel computes one output row from the rows above, at and below it.
+// Each input row must have a readable guard word on both sides, at index -1
+// and at index `words`; the caller fills them (and any bits past the board
+// edge) with whatever wrap-around or dead border the board uses.
+typedef void (*LifeRowKernel)(const uint64_t *up, const uint64_t *mid,
+                              const uint64_t *down, uint64_t *out, int words);
+
+enum LifeKernelType
+{
+    KERNEL_PORTABLE, // Plain 64-bit words, any CPU
+    KERNEL_SSE2,     // 128-bit, x86 only
+    KERNEL_AVX2      // 256-bit, x86 only, chosen at run time
+};
+
+bool lifeKernelSupported(LifeKernelType type);
+LifeKernelType lifeBestKernel();
+LifeRowKernel lifeRowKernel(LifeKernelType type);
+const char *lifeKernelName(LifeKernelType type);
@@ -0,0 +1,388 @@
+#include "LifeNode.h"
+#include <string.h>
+
+#ifdef ESP32
+#include <lwip/sockets.h>
+#include <esp_timer.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#endif
+
+// Packet: 'L' 'N' dir pad exchange(4, little endian) then the packed strip.
+// dir is where the receiver sits as seen from the sender.
+static const int HEADER_SIZE = 8;
+static const int MAX_PACKET = 1400;
+
+// Neighbour directions, row-major around the centre
+static const int DIR_X[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+static const int DIR_Y[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+
+static int dirIndex(int dx, int dy)
+{
+    for (int d = 0; d < 8; d++)
+    {
+        if (DIR_X[d] == dx && DIR_Y[d] == dy)
+            return d;
+    }
+    return -1;
+}
+
+LifeNode::LifeNode(const Config &config) : cfg(config)
+{
+    stride = cfg.tileWidth + 2 * cfg.haloDepth;
+    cells.assign(stride * (cfg.tileHeight + 2 * cfg.haloDepth), 0);
+    nextCells = cells;
+}
+
+LifeNode::~LifeNode()
+{
+    end();
+}
+
+bool LifeNode::begin()
+{
+    int nodes = cfg.gridWidth * cfg.gridHeight;
+    if (cfg.haloDepth < 1 || cfg.haloDepth > cfg.tileWidth || cfg.haloDepth > cfg.tileHeight)
+        return false;
+    // The widest strip has to fit in one datagram
+    int maxSide = cfg.tileWidth > cfg.tileHeight ? cfg.tileWidth : cfg.tileHeight;
+    if (HEADER_SIZE + (maxSide * cfg.haloDepth + 7) / 8 > MAX_PACKET)
+        return false;
+
+    peerAddress.resize(nodes);
+    for (int i = 0; i < nodes; i++)
+    {
+        struct in_addr addr;
+        if (inet_aton(cfg.hosts[i], &addr) == 0)
+            return false;
+        peerAddress[i] = addr.s_addr;
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0)
+        return false;
+
+    struct sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(cfg.basePort + cfg.index);
+    if (bind(sock, (struct sockaddr *)&local, sizeof(local)) < 0)
+    {
+        end();
+        return false;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    for (int s = 0; s < 3; s++)
+        slots[s].exchange = -1;
+    exchangeOpen = false;
+    stats = Stats();
+    return true;
+}
+
+void LifeNode::end()
+{
+    if (sock >= 0)
+    {
+        close(sock);
+        sock = -1;
+    }
+}
+
+void LifeNode::loadTile(const GameOfLife &global)
+{
+    int ox = getOriginX(), oy = getOriginY();
+    for (int y = 0; y < cfg.tileHeight; y++)
+        for (int x = 0; x < cfg.tileWidth; x++)
+            *at(cells, x, y) = global.getCell(ox + x, oy + y);
+}
+
+bool LifeNode::getCell(int x, int y) const
+{
+    if (x < 0 || x >= cfg.tileWidth || y < 0 || y >= cfg.tileHeight)
+        return false;
+    return *at(cells, x, y);
+}
+
+void LifeNode::setCell(int x, int y, bool state)
+{
+    if (x >= 0 && x < cfg.tileWidth && y >= 0 && y < cfg.tileHeight)
+        *at(cells, x, y) = state;
+}
+
+int LifeNode::neighbourIndex(int dir) const
+{
+    int gx = cfg.index % cfg.gridWidth + DIR_X[dir];
+    int gy = cfg.index / cfg.gridWidth + DIR_Y[dir];
+    gx = (gx + cfg.gridWidth) % cfg.gridWidth;
+    gy = (gy + cfg.gridHeight) % cfg.gridHeight;
+    return gy * cfg.gridWidth + gx;
+}
+
+// The strip of our tile facing direction (dx, dy), or with halo set, the
+// part of the halo that a neighbour in that direction fills
+void LifeNode::stripBounds(int dx, int dy, bool halo, int &x0, int &y0, int &w, int &h) const
+{
+    int L = cfg.haloDepth;
+    if (dx == 0)
+    {
+        x0 = 0;
+        w = cfg.tileWidth;
+    }
+    else
+    {
+        x0 = dx < 0 ? (halo ? -L : 0) : (halo ? cfg.tileWidth : cfg.tileWidth - L);
+        w = L;
+    }
+    if (dy == 0)
+    {
+        y0 = 0;
+        h = cfg.tileHeight;
+    }
+    else
+    {
+        y0 = dy < 0 ? (halo ? -L : 0) : (halo ? cfg.tileHeight : cfg.tileHeight - L);
+        h = L;
+    }
+}
+
+LifeNode::Slot &LifeNode::slotFor(int32_t exchange)
+{
+    Slot &slot = slots[exchange % 3];
+    if (slot.exchange != exchange)
+    {
+        slot.exchange = exchange;
+        for (int d = 0; d < NEIGHBOURS; d++)
+        {
+            slot.outgoing[d].clear();
+            slot.received[d] = false;
+        }
+    }
+    return slot;
+}
+
+void LifeNode::beginExchange(int32_t exchange)
+{
+    Slot &slot = slotFor(exchange);
+    exchangeStart = nowMicros();
+
+    for (int d = 0; d < NEIGHBOURS; d++)
+    {
+        int x0, y0, w, h;
+        stripBounds(DIR_X[d], DIR_Y[d], false, x0, y0, w, h);
+
+        std::vector<uint8_t> &pkt = slot.outgoing[d];
+        pkt.assign(HEADER_SIZE + (w * h + 7) / 8, 0);
+        pkt[0] = 'L';
+        pkt[1] = 'N';
+        pkt[2] = d;
+        for (int i = 0; i < 4; i++)
+            pkt[4 + i] = (uint8_t)(exchange >> (8 * i));
+
+        int bit = 0;
+        for (int y = y0; y < y0 + h; y++)
+        {
+            for (int x = x0; x < x0 + w; x++, bit++)
+            {
+                if (*at(cells, x, y))
+                    pkt[HEADER_SIZE + bit / 8] |= 1 << (bit % 8);
+            }
+        }
+        sendSlot(slot, d);
+    }
+    exchangeOpen = true;
+}
+
+void LifeNode::sendSlot(Slot &slot, int dir)
+{
+    const std::vector<uint8_t> &pkt = slot.outgoing[dir];
+    if (pkt.empty())
+        return;
+
+    int peer = neighbourIndex(dir);
+    struct sockaddr_in to = {};
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = peerAddress[peer];
+    to.sin_port = htons(cfg.basePort + peer);
+    if (sendto(sock, pkt.data(), pkt.size(), 0, (struct sockaddr *)&to, sizeof(to)) > 0)
+        stats.bytesSent += pkt.size();
+}
+
+bool LifeNode::exchangeComplete(int32_t exchange) const
+{
+    const Slot &slot = slots[exchange % 3];
+    if (slot.exchange != exchange)
+        return false;
+    for (int d = 0; d < NEIGHBOURS; d++)
+    {
+        if (!slot.received[d])
+            return false;
+    }
+    return true;
+}
+
+void LifeNode::handlePacket(const uint8_t *data, int len)
+{
+    if (len < HEADER_SIZE || data[0] != 'L' || data[1] != 'N' || data[2] >= NEIGHBOURS)
+        return;
+    int32_t exchange = 0;
+    for (int i = 0; i < 4; i++)
+        exchange |= (int32_t)data[4 + i] << (8 * i);
+
+    // The sender sits opposite the direction it sent towards
+    int from = dirIndex(-DIR_X[data[2]], -DIR_Y[data[2]]);
+    int32_t current = stats.generation / cfg.haloDepth;
+
+    if (exchange == current - 1)
+    {
+        // The sender is still waiting for this exchange, so our strip got lost
+        Slot &old = slots[exchange % 3];
+        if (old.exchange == exchange)
+        {
+            sendSlot(old, from);
+            stats.resends++;
+        }
+        return;
+    }
+    if (exchange != current && exchange != current + 1)
+        return;
+
+    Slot &slot = slotFor(exchange);
+    int x0, y0, w, h;
+    stripBounds(DIR_X[from], DIR_Y[from], true, x0, y0, w, h);
+    if (len < HEADER_SIZE + (w * h + 7) / 8)
+        return;
+    slot.incoming[from].assign(data + HEADER_SIZE, data + len);
+    slot.received[from] = true;
+}
+
+void LifeNode::pollSocket(uint32_t waitMs)
+{
+    if (sock < 0)
+        return;
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(sock, &readable);
+    struct timeval tv;
+    tv.tv_sec = waitMs / 1000;
+    tv.tv_usec = (waitMs % 1000) * 1000;
+    if (select(sock + 1, &readable, nullptr, nullptr, &tv) <= 0)
+        return;
+
+    uint8_t buf[MAX_PACKET];
+    int len;
+    while ((len = recvfrom(sock, buf, sizeof(buf), 0, nullptr, nullptr)) > 0)
+        handlePacket(buf, len);
+}
+
+void LifeNode::unpackHalos(Slot &slot)
+{
+    for (int d = 0; d < NEIGHBOURS; d++)
+    {
+        int x0, y0, w, h;
+        stripBounds(DIR_X[d], DIR_Y[d], true, x0, y0, w, h);
+        const std::vector<uint8_t> &strip = slot.incoming[d];
+        int bit = 0;
+        for (int y = y0; y < y0 + h; y++)
+        {
+            for (int x = x0; x < x0 + w; x++, bit++)
+                *at(cells, x, y) = (strip[bit / 8] >> (bit % 8)) & 1;
+        }
+    }
+}
+
+void LifeNode::computeStep(int shrink)
+{
+    // Each generation since the exchange leaves one more ring of the halo stale
+    int L = cfg.haloDepth;
+    for (int y = -L + shrink; y < cfg.tileHeight + L - shrink; y++)
+    {
+        for (int x = -L + shrink; x < cfg.tileWidth + L - shrink; x++)
+        {
+            const uint8_t *up = at(cells, x, y - 1);
+            const uint8_t *mid = at(cells, x, y);
+            const uint8_t *down = at(cells, x, y + 1);
+            int neighbors = up[-1] + up[0] + up[1] + mid[-1] + mid[1] +
+                            down[-1] + down[0] + down[1];
+            bool currentCell = mid[0];
+            *at(nextCells, x, y) = (currentCell && (neighbors == 2 || neighbors == 3)) ||
+                                   (!currentCell && neighbors == 3);
+        }
+    }
+    cells.swap(nextCells);
+}
+
+bool LifeNode::advance(uint32_t timeoutMs)
+{
+    // Not started: there is nobody to exchange with yet
+    if (sock < 0)
+        return false;
+    int L = cfg.haloDepth;
+    int shrink = stats.generation % L;
+    int32_t exchange = stats.generation / L;
+
+    if (shrink == 0)
+    {
+        if (!exchangeOpen)
+            beginExchange(exchange);
+
+        uint64_t start = nowMicros();
+        uint64_t lastSend = start;
+        while (!exchangeComplete(exchange))
+        {
+            uint64_t now = nowMicros();
+            if (now - start >= (uint64_t)timeoutMs * 1000)
+                return false;
+            if (now - lastSend >= (uint64_t)cfg.resendMs * 1000)
+            {
+                // Either our strip or theirs was lost; resending ours also
+                // makes a neighbour that has moved on resend its own
+                Slot &slot = slots[exchange % 3];
+                for (int d = 0; d < NEIGHBOURS; d++)
+                {
+                    if (!slot.received[d])
+                    {
+                        sendSlot(slot, d);
+                        stats.resends++;
+                    }
+                }
+                lastSend = now;
+            }
+            pollSocket(cfg.resendMs);
+        }
+
+        stats.lastExchangeUs = nowMicros() - exchangeStart;
+        if (stats.lastExchangeUs > stats.maxExchangeUs)
+            stats.maxExchangeUs = stats.lastExchangeUs;
+        stats.totalExchangeUs += stats.lastExchangeUs;
+        stats.exchanges++;
+        exchangeOpen = false;
+        unpackHalos(slots[exchange % 3]);
+    }
+    else
+    {
+        // Answer any neighbours without blocking
+        pollSocket(0);
+    }
+
+    computeStep(shrink + 1);
+    stats.generation++;
+    return true;
+}
+
+uint64_t LifeNode::nowMicros()
+{
+#ifdef ESP32
+    return esp_timer_get_time();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "life.h"
+
+// One tile of a Life board partitioned across several controllers.
+// The nodes form a gridWidth x gridHeight torus. Each one owns a
+// tileWidth x tileHeight tile and swaps packed edge strips with its eight
+// neighbours over UDP.
+//
+// haloDepth sets the synchronisation: with 1 the nodes exchange every
+// generation (lockstep). With L they exchange L-deep strips every L
+// generations and compute the generations in between on a shrinking halo,
+// so neighbours may drift up to L generations apart.
+class LifeNode
+{
+public:
+    struct Config
+    {
+        int gridWidth;          // Nodes across
+        int gridHeight;         // Nodes down
+        int tileWidth;          // Cells per node
+        int tileHeight;
+        int index;              // This node, row-major in the grid
+        int haloDepth;          // Generations per exchange
+        uint16_t basePort;      // Node i listens on basePort + i
+        const char *const *hosts; // IPv4 address of each node, in index order
+        uint32_t resendMs;      // Resend interval while waiting for neighbours
+    };
+
+    struct Stats
+    {
+        unsigned int generation;
+        uint32_t lastExchangeUs; // Send of our strips to arrival of all eight
+        uint32_t maxExchangeUs;
+        uint64_t totalExchangeUs;
+        uint32_t exchanges;
+        uint32_t resends;
+        uint32_t bytesSent;
+
+        uint32_t meanExchangeUs() const { return exchanges ? totalExchangeUs / exchanges : 0; }
+    };
+
+    LifeNode(const Config &config);
+    ~LifeNode();
+
+    bool begin();
+    void end();
+    // begin() has succeeded and end() not been called
+    bool isStarted() const { return sock >= 0; }
+
+    // Take this node's tile from a board the size of the whole installation
+    void loadTile(const GameOfLife &global);
+    bool getCell(int x, int y) const;
+    void setCell(int x, int y, bool state);
+    int getTileWidth() const { return cfg.tileWidth; }
+    int getTileHeight() const { return cfg.tileHeight; }
+    int getOriginX() const { return (cfg.index % cfg.gridWidth) * cfg.tileWidth; }
+    int getOriginY() const { return (cfg.index / cfg.gridWidth) * cfg.tileHeight; }
+
+    // Advance one generation, exchanging halos first when due.
+    // Returns false if the neighbours did not answer within timeoutMs;
+    // call again to keep waiting. Also false, at once, until begin().
+    bool advance(uint32_t timeoutMs);
+    // Answer neighbours between generations (and after the last one)
+    void service(uint32_t waitMs) { pollSocket(waitMs); }
+    unsigned int getGenerationCount() const { return stats.generation; }
+    const Stats &getStats() const { return stats; }
+
+private:
+    static const int NEIGHBOURS = 8;
+
+    Config cfg;
+    int sock = -1;
+    std::vector<uint32_t> peerAddress; // Network byte order, by node index
+    int stride;               // Row length of the local buffer, halo included
+    std::vector<uint8_t> cells;
+    std::vector<uint8_t> nextCells;
+    Stats stats = {};
+
+    // Three exchanges are kept: the previous one (to answer a lagging
+    // neighbour), the current one and the next (from a neighbour ahead).
+    struct Slot
+    {
+        int32_t exchange = -1;
+        std::vector<uint8_t> outgoing[NEIGHBOURS]; // Our packets, kept for resends
+        std::vector<uint8_t> incoming[NEIGHBOURS]; // Neighbours' strips
+        bool received[NEIGHBOURS];
+    };
+    Slot slots[3];
+    bool exchangeOpen = false;
+    uint64_t exchangeStart = 0;
+
+    int neighbourIndex(int dir) const;
+    uint8_t *at(std::vector<uint8_t> &buf, int x, int y) { return &buf[(y + cfg.haloDepth) * stride + x + cfg.haloDepth]; }
+    const uint8_t *at(const std::vector<uint8_t> &buf, int x, int y) const { return &buf[(y + cfg.haloDepth) * stride + x + cfg.haloDepth]; }
+    void stripBounds(int dx, int dy, bool halo, int &x0, int &y0, int &w, int &h) const;
+
+    Slot &slotFor(int32_t exchange);
+    void beginExchange(int32_t exchange);
+    bool exchangeComplete(int32_t exchange) const;
+    void sendSlot(Slot &slot, int dir);
+    void pollSocket(uint32_t waitMs);
+    void handlePacket(const uint8_t *data, int len);
+    void unpackHalos(Slot &slot);
+    void computeStep(int shrink);
+    static uint64_t nowMicros();
+};
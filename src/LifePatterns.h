@@ -0,0 +1,88 @@
+#pragma once
+
+// Pattern stamps shared by every board type with a setCell(x, y, state)
+// method, so the unbounded plane builds exactly the same shapes.
+
+template <typename Board>
+void stampGlider(Board &board, int startX, int startY)
+{
+    board.setCell(startX + 1, startY, true);     // .#.
+    board.setCell(startX + 2, startY + 1, true); // ..#
+    board.setCell(startX, startY + 2, true);     // ###
+    board.setCell(startX + 1, startY + 2, true);
+    board.setCell(startX + 2, startY + 2, true);
+}
+
+template <typename Board>
+void stampBlinker(Board &board, int startX, int startY)
+{
+    board.setCell(startX, startY, true); // ###
+    board.setCell(startX + 1, startY, true);
+    board.setCell(startX + 2, startY, true);
+}
+
+template <typename Board>
+void stampPulsar(Board &board, int startX, int startY)
+{
+    // Outer squares
+    for (int i = 0; i < 3; i++)
+    {
+        board.setCell(startX + 2 + i, startY, true);
+        board.setCell(startX + 2 + i, startY + 5, true);
+        board.setCell(startX + 8 + i, startY, true);
+        board.setCell(startX + 8 + i, startY + 5, true);
+
+        board.setCell(startX, startY + 2 + i, true);
+        board.setCell(startX + 5, startY + 2 + i, true);
+        board.setCell(startX + 7, startY + 2 + i, true);
+        board.setCell(startX + 12, startY + 2 + i, true);
+    }
+}
+
+template <typename Board>
+void stampGliderGun(Board &board, int startX, int startY)
+{
+    // Left square
+    board.setCell(startX + 1, startY + 5, true);
+    board.setCell(startX + 2, startY + 5, true);
+    board.setCell(startX + 1, startY + 6, true);
+    board.setCell(startX + 2, startY + 6, true);
+
+    // Left pattern
+    board.setCell(startX + 11, startY + 5, true);
+    board.setCell(startX + 11, startY + 6, true);
+    board.setCell(startX + 11, startY + 7, true);
+    board.setCell(startX + 12, startY + 4, true);
+    board.setCell(startX + 12, startY + 8, true);
+    board.setCell(startX + 13, startY + 3, true);
+    board.setCell(startX + 13, startY + 9, true);
+    board.setCell(startX + 14, startY + 3, true);
+    board.setCell(startX + 14, startY + 9, true);
+    board.setCell(startX + 15, startY + 6, true);
+    board.setCell(startX + 16, startY + 4, true);
+    board.setCell(startX + 16, startY + 8, true);
+    board.setCell(startX + 17, startY + 5, true);
+    board.setCell(startX + 17, startY + 6, true);
+    board.setCell(startX + 17, startY + 7, true);
+    board.setCell(startX + 18, startY + 6, true);
+
+    // Right pattern
+    board.setCell(startX + 21, startY + 3, true);
+    board.setCell(startX + 21, startY + 4, true);
+    board.setCell(startX + 21, startY + 5, true);
+    board.setCell(startX + 22, startY + 3, true);
+    board.setCell(startX + 22, startY + 4, true);
+    board.setCell(startX + 22, startY + 5, true);
+    board.setCell(startX + 23, startY + 2, true);
+    board.setCell(startX + 23, startY + 6, true);
+    board.setCell(startX + 25, startY + 1, true);
+    board.setCell(startX + 25, startY + 2, true);
+    board.setCell(startX + 25, startY + 6, true);
+    board.setCell(startX + 25, startY + 7, true);
+
+    // Right square
+    board.setCell(startX + 35, startY + 3, true);
+    board.setCell(startX + 35, startY + 4, true);
+    board.setCell(startX + 36, startY + 3, true);
+    board.setCell(startX + 36, startY + 4, true);
+}
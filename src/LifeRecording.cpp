@@ -0,0 +1,400 @@
+#include "LifeRecording.h"
+#include <string.h>
+
+#ifdef ESP32
+#include <SPIFFS.h>
+#else
+#include <stdio.h>
+#endif
+
+static void putVarint(LifeVector<uint8_t> &out, uint32_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(v);
+}
+
+static bool readVarint(const uint8_t *&p, const uint8_t *end, uint32_t &v)
+{
+    v = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7)
+    {
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static void put32(LifeVector<uint8_t> &out, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        out.push_back(v >> (8 * i));
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void LifeRecorder::encodeRuns(LifeVector<uint8_t> &out, const uint8_t *bytes, size_t n)
+{
+    size_t i = 0;
+    while (i < n)
+    {
+        size_t start = i;
+        // Whole zero words first; deltas are mostly made of them
+        while (i % 8 == 0 && i + 8 <= n)
+        {
+            uint64_t word;
+            memcpy(&word, bytes + i, 8);
+            if (word)
+                break;
+            i += 8;
+        }
+        while (i < n && bytes[i] == 0)
+            i++;
+        size_t zeros = i - start;
+
+        // A lone zero costs less inside the literal than as a new pair
+        size_t literal = i;
+        while (i < n && (bytes[i] != 0 || (i + 1 < n && bytes[i + 1] != 0)))
+            i++;
+
+        putVarint(out, zeros);
+        putVarint(out, i - literal);
+        out.insert(out.end(), bytes + literal, bytes + i);
+    }
+}
+
+static bool decodeRuns(const uint8_t *p, const uint8_t *end, uint8_t *out, size_t n, bool xorInto)
+{
+    size_t i = 0;
+    while (i < n)
+    {
+        uint32_t zeros, literal;
+        if (!readVarint(p, end, zeros) || !readVarint(p, end, literal))
+            return false;
+        if (zeros > n - i || literal > n - i - zeros || literal > (size_t)(end - p))
+            return false;
+        i += zeros;
+        if (xorInto)
+        {
+            for (uint32_t j = 0; j < literal; j++)
+                out[i + j] ^= p[j];
+        }
+        else
+            memcpy(out + i, p, literal);
+        p += literal;
+        i += literal;
+    }
+    return true;
+}
+
+LifeRecorder::LifeRecorder(unsigned int keyframeInterval, size_t maxBytes)
+    : interval(keyframeInterval ? keyframeInterval : 1), maxBytes(maxBytes),
+      frames(0), lastGeneration(0), recording(false), ended(false)
+{
+}
+
+void LifeRecorder::begin(const GameOfLife &life)
+{
+    size_t words = life.getWordsPerRow() * life.getHeight();
+#if LIFE_STATIC_MEMORY
+    // Everything at its largest up front, so the arena is only taken once
+    if (maxBytes)
+    {
+        stream.reserve(maxBytes + indexBytes(interval, maxBytes));
+        previous.reserve(words);
+        scratch.reserve(payloadBytes(words * sizeof(uint64_t), interval, maxBytes));
+        keyframes.reserve(maxKeyframes(interval, maxBytes));
+    }
+#endif
+    stream.clear();
+    keyframes.clear();
+    previous.assign(words, 0);
+    frames = 0;
+    recording = true;
+    ended = false;
+
+    stream.insert(stream.end(), {'L', 'R', 'E', 'C'});
+    stream.push_back(VERSION & 0xFF);
+    stream.push_back(VERSION >> 8);
+    stream.push_back(life.getWrapAround() ? 1 : 0);
+    stream.push_back(0);
+    put32(stream, life.getWidth());
+    put32(stream, life.getHeight());
+    put32(stream, interval);
+    record(life);
+}
+
+bool LifeRecorder::record(const GameOfLife &life)
+{
+    if (!recording)
+        return false;
+
+    // Rows are contiguous, little endian words
+    const uint64_t *cells = life.getRow(0);
+    size_t words = previous.size();
+    bool keyframe = frames % interval == 0;
+
+    scratch.clear();
+    if (keyframe)
+    {
+        putVarint(scratch, life.getGenerationCount());
+        encodeRuns(scratch, (const uint8_t *)cells, words * sizeof(uint64_t));
+    }
+    else
+    {
+        putVarint(scratch, life.getGenerationCount() - lastGeneration);
+        for (size_t i = 0; i < words; i++)
+            previous[i] ^= cells[i];
+        encodeRuns(scratch, (const uint8_t *)previous.data(), words * sizeof(uint64_t));
+    }
+    memcpy(previous.data(), cells, words * sizeof(uint64_t));
+
+    // Leave room for the record header
+    if (maxBytes && stream.size() + scratch.size() + 6 > maxBytes)
+    {
+        recording = false;
+        return false;
+    }
+    if (keyframe)
+        keyframes.push_back(stream.size());
+    appendRecord(keyframe ? 'K' : 'D');
+    lastGeneration = life.getGenerationCount();
+    frames++;
+    return true;
+}
+
+void LifeRecorder::appendRecord(uint8_t type)
+{
+    stream.push_back(type);
+    putVarint(stream, scratch.size());
+    stream.insert(stream.end(), scratch.begin(), scratch.end());
+}
+
+void LifeRecorder::end()
+{
+    if (ended || stream.empty())
+        return;
+
+    scratch.clear();
+    putVarint(scratch, frames);
+    putVarint(scratch, keyframes.size());
+    uint32_t last = 0;
+    for (size_t i = 0; i < keyframes.size(); i++)
+    {
+        putVarint(scratch, keyframes[i] - last);
+        last = keyframes[i];
+    }
+    uint32_t indexOffset = stream.size();
+    appendRecord('I');
+    put32(stream, indexOffset);
+    stream.insert(stream.end(), {'L', 'I', 'D', 'X'});
+    recording = false;
+    ended = true;
+}
+
+bool LifeRecorder::saveFile(const char *path) const
+{
+#ifdef ESP32
+    File f = SPIFFS.open(path, FILE_WRITE);
+    if (!f)
+        return false;
+    size_t written = f.write(stream.data(), stream.size());
+    f.close();
+    return written == stream.size();
+#else
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(stream.data(), 1, stream.size(), f) == stream.size();
+    return fclose(f) == 0 && ok;
+#endif
+}
+
+bool LifePlayer::open(const uint8_t *d, size_t len)
+{
+    data = d;
+    length = len;
+    if (len < LifeRecorder::HEADER_SIZE || memcmp(d, "LREC", 4) != 0)
+        return false;
+    version = d[4] | (d[5] << 8);
+    if (version < 1 || version > LifeRecorder::VERSION)
+        return false;
+    // Nothing carries over from a stream opened before
+    frame = 0;
+    position = 0;
+    generation = 0;
+    frameCount = 0;
+    keyframes.clear();
+    board.clear();
+
+    uint32_t w = get32(d + 8), h = get32(d + 12);
+    // As a snapshot's header: a board must be able to take them
+    if (!GameOfLife::validSize(w, h))
+        return false;
+    wrapAround = d[6] & 1;
+    width = w;
+    height = h;
+    interval = get32(d + 16);
+    if (interval == 0)
+        return false;
+    wordsPerRow = (width + 63) / 64;
+    board.assign((size_t)wordsPerRow * height, 0);
+
+    if (!readIndex() && !scanRecords())
+        return false;
+    return frameCount > 0 && seek(0);
+}
+
+bool LifePlayer::readRecord(size_t &pos, uint8_t &type, const uint8_t *&payload, uint32_t &payloadLen) const
+{
+    if (pos >= length)
+        return false;
+    const uint8_t *p = data + pos;
+    const uint8_t *end = data + length;
+    type = *p++;
+    if (!readVarint(p, end, payloadLen) || payloadLen > (size_t)(end - p))
+        return false;
+    payload = p;
+    pos = p + payloadLen - data;
+    return true;
+}
+
+bool LifePlayer::readIndex()
+{
+    if (length < LifeRecorder::HEADER_SIZE + 8 || memcmp(data + length - 4, "LIDX", 4) != 0)
+        return false;
+    size_t pos = get32(data + length - 8);
+    uint8_t type;
+    const uint8_t *p;
+    uint32_t len;
+    if (pos < LifeRecorder::HEADER_SIZE || !readRecord(pos, type, p, len) || type != 'I')
+        return false;
+
+    const uint8_t *end = p + len;
+    uint32_t frames, count, offset = 0, step;
+    if (!readVarint(p, end, frames) || !readVarint(p, end, count))
+        return false;
+    if (count > len)
+        return false;
+    frameCount = frames;
+    keyframes.clear();
+    keyframes.reserve(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (!readVarint(p, end, step))
+            return false;
+        offset += step;
+        keyframes.push_back(offset);
+    }
+    return !keyframes.empty() && (frameCount + interval - 1) / interval == keyframes.size();
+}
+
+// Without an index: one pass over the record headers
+bool LifePlayer::scanRecords()
+{
+    keyframes.clear();
+    frameCount = 0;
+    size_t pos = LifeRecorder::HEADER_SIZE;
+    uint8_t type;
+    const uint8_t *p;
+    uint32_t len;
+    for (size_t at = pos; readRecord(pos, type, p, len); at = pos)
+    {
+        if (type == 'K')
+            keyframes.push_back(at);
+        else if (type != 'D')
+            break;
+        frameCount++;
+    }
+    // A frame only counts if its keyframe made it to the stream
+    if (frameCount > keyframes.size() * interval)
+        frameCount = keyframes.size() * interval;
+    return !keyframes.empty();
+}
+
+bool LifePlayer::decode(size_t pos)
+{
+    uint8_t type;
+    const uint8_t *p;
+    uint32_t len;
+    if (!readRecord(pos, type, p, len))
+        return false;
+    const uint8_t *end = p + len;
+    uint8_t *bytes = (uint8_t *)board.data();
+    size_t n = board.size() * sizeof(uint64_t);
+
+    if (type == 'K')
+    {
+        uint32_t gen;
+        if (!readVarint(p, end, gen))
+            return false;
+        memset(bytes, 0, n);
+        if (!decodeRuns(p, end, bytes, n, false))
+            return false;
+        generation = gen;
+    }
+    else if (type == 'D')
+    {
+        uint32_t step = 1;
+        if (version >= 2 && !readVarint(p, end, step))
+            return false;
+        if (!decodeRuns(p, end, bytes, n, true))
+            return false;
+        generation += step;
+    }
+    else
+        return false;
+    position = pos;
+    return true;
+}
+
+bool LifePlayer::next()
+{
+    if (frame + 1 >= frameCount || !decode(position))
+        return false;
+    frame++;
+    return true;
+}
+
+bool LifePlayer::seek(unsigned int target)
+{
+    if (target >= frameCount)
+        return false;
+    // Carry on forwards when the target is later in the same keyframe block
+    unsigned int key = target / interval;
+    if (!(frame <= target && frame / interval == key && position > 0))
+    {
+        if (!decode(keyframes[key]))
+            return false;
+        frame = key * interval;
+    }
+    while (frame < target)
+    {
+        if (!next())
+            return false;
+    }
+    return true;
+}
+
+bool LifePlayer::getCell(int x, int y) const
+{
+    if (x < 0 || x >= width || y < 0 || y >= height)
+        return false;
+    return (getRow(y)[x / 64] >> (x % 64)) & 1;
+}
+
+void LifePlayer::copyTo(GameOfLife &life) const
+{
+    if (life.getWidth() != width || life.getHeight() != height)
+        return;
+    for (int y = 0; y < height; y++)
+        life.setRow(y, getRow(y));
+}
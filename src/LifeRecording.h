@@ -0,0 +1,146 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "life.h"
+
+// A recorded run, one frame per recorded generation, as an append-only stream.
+// Little endian throughout:
+//
+//   header   'L' 'R' 'E' 'C', uint16 version, uint16 flags (bit 0 = wrap-around),
+//            uint32 width, uint32 height, uint32 keyframe interval
+//   records  type byte, varint payload length, payload:
+//     'K'    keyframe: varint generation, then the packed board run-length coded
+//     'D'    delta: varint generations since the previous frame (more than
+//            1 when recorded after stepN()), then the packed board XOR the
+//            previous frame, run-length coded. Version 1 had no step, always 1.
+//     'I'    index, from end(): varint frame count, varint keyframe count,
+//            then each keyframe's offset as a varint step from the last
+//   trailer  uint32 offset of the index record, 'L' 'I' 'D' 'X'
+//
+// The packed board is GameOfLife::getRow() order. Run-length coding is a
+// series of (varint zero bytes, varint literal bytes, literals) covering the
+// whole board; an XOR delta between similar frames is nearly all zeros.
+//
+// Every keyframeInterval-th frame is a keyframe, so seeking decodes one
+// keyframe and at most interval - 1 deltas. A stream without the index
+// (say a recording cut short by a reset) still plays.
+class LifeRecorder
+{
+public:
+    static const uint16_t VERSION = 2;
+    static const size_t HEADER_SIZE = 20;
+
+    // maxBytes = 0 records without limit
+    LifeRecorder(unsigned int keyframeInterval = 64, size_t maxBytes = 0);
+
+    // Keyframes a stream of maxBytes can hold; every record takes at least 4 bytes
+    static constexpr size_t maxKeyframes(unsigned int interval, size_t maxBytes)
+    {
+        return maxBytes / 4 / interval + 1;
+    }
+    // Largest index record and trailer
+    static constexpr size_t indexBytes(unsigned int interval, size_t maxBytes)
+    {
+        return 24 + 5 * maxKeyframes(interval, maxBytes);
+    }
+    // Largest payload: a run-length coded frame of n bytes with its varint
+    // generation or step, or the index
+    static constexpr size_t payloadBytes(size_t n, unsigned int interval, size_t maxBytes)
+    {
+        return 2 * n + 16 > indexBytes(interval, maxBytes) ? 2 * n + 16 : indexBytes(interval, maxBytes);
+    }
+    // Arena space (LIFE_STATIC_MEMORY) for recording a w x h board; needs maxBytes
+    static constexpr size_t arenaBytes(int w, int h, unsigned int interval, size_t maxBytes)
+    {
+        return LifeArena::blockBytes(maxBytes + indexBytes(interval, maxBytes)) +
+               LifeArena::blockBytes((size_t)(w + 63) / 64 * h * 8) +
+               LifeArena::blockBytes(payloadBytes((size_t)(w + 63) / 64 * h * 8, interval, maxBytes)) +
+               LifeArena::blockBytes(maxKeyframes(interval, maxBytes) * sizeof(uint32_t));
+    }
+
+    // Start a new stream with the board as frame 0
+    void begin(const GameOfLife &life);
+    // Add the board as the next frame; false once the stream is full or ended
+    bool record(const GameOfLife &life);
+    // Append the index and trailer
+    void end();
+
+    const LifeVector<uint8_t> &getStream() const { return stream; }
+    unsigned int getFrameCount() const { return frames; }
+    // What the same frames take unencoded
+    size_t getRawBytes() const { return (size_t)frames * previous.size() * sizeof(uint64_t); }
+
+    bool saveFile(const char *path) const; // SPIFFS on the ESP32
+
+    // Append n bytes as (varint zero bytes, varint literal bytes, literals) pairs
+    static void encodeRuns(LifeVector<uint8_t> &out, const uint8_t *bytes, size_t n);
+
+private:
+    unsigned int interval;
+    size_t maxBytes;
+    LifeVector<uint8_t> stream;
+    LifeVector<uint64_t> previous; // Last recorded frame
+    LifeVector<uint8_t> scratch;   // Payload being built
+    LifeVector<uint32_t> keyframes;
+    unsigned int frames;
+    unsigned int lastGeneration; // Of the previous frame
+    bool recording; // Accepting frames
+    bool ended;     // Index written
+
+    void appendRecord(uint8_t type);
+};
+
+// Plays back a stream from memory: a LifeRecorder's, a file read into RAM,
+// or on a host a memory-mapped file. The data must outlive the player.
+class LifePlayer
+{
+public:
+    LifePlayer() {}
+
+    bool open(const uint8_t *data, size_t len);
+
+    // Arena space (LIFE_STATIC_MEMORY) for playing a w x h stream with an index
+    static constexpr size_t arenaBytes(int w, int h, unsigned int interval, size_t maxBytes)
+    {
+        return LifeArena::blockBytes((size_t)(w + 63) / 64 * h * 8) +
+               LifeArena::blockBytes(LifeRecorder::maxKeyframes(interval, maxBytes) * sizeof(uint32_t));
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    bool getWrapAround() const { return wrapAround; }
+    unsigned int getKeyframeInterval() const { return interval; }
+    unsigned int getFrameCount() const { return frameCount; }
+    unsigned int getFrame() const { return frame; }
+    unsigned int getGeneration() const { return generation; }
+
+    // Decode the next frame; false at the end of the stream
+    bool next();
+    bool seek(unsigned int frame);
+
+    bool getCell(int x, int y) const;
+    const uint64_t *getRow(int y) const { return board.data() + (size_t)y * wordsPerRow; }
+    // Load the current frame into a board of the same size
+    void copyTo(GameOfLife &life) const;
+
+private:
+    const uint8_t *data = nullptr;
+    size_t length = 0;
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    uint16_t version = 0;
+    bool wrapAround = false;
+    unsigned int interval = 0;
+    unsigned int frameCount = 0;
+    LifeVector<uint32_t> keyframes; // Offset of every keyframe record
+    LifeVector<uint64_t> board;
+    size_t position = 0;             // Offset of the next record
+    unsigned int frame = 0;
+    unsigned int generation = 0;
+
+    bool readRecord(size_t &pos, uint8_t &type, const uint8_t *&payload, uint32_t &payloadLen) const;
+    bool readIndex();
+    bool scanRecords();
+    bool decode(size_t pos);
+};
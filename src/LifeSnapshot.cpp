@@ -0,0 +1,320 @@
+#include "LifeSnapshot.h"
+#include <string.h>
+#include "LifeTrace.h"
+
+#ifdef ESP32
+#include <Preferences.h>
+#include <SPIFFS.h>
+#else
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = v >> (8 * i);
+}
+
+static void put64(uint8_t *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        p[i] = v >> (8 * i);
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t get64(const uint8_t *p)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+uint32_t LifeSnapshot::crc32(const uint8_t *data, size_t len)
+{
+    // Reflected CRC-32 (as zlib), a nibble at a time
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ table[crc & 15];
+        crc = (crc >> 4) ^ table[crc & 15];
+    }
+    return ~crc;
+}
+
+size_t LifeSnapshot::size(const GameOfLife &life)
+{
+    return size(life.getWidth(), life.getHeight());
+}
+
+size_t LifeSnapshot::save(const GameOfLife &life, uint8_t *out, size_t capacity)
+{
+    size_t total = size(life);
+    if (capacity < total)
+        return 0;
+
+    memset(out, 0, HEADER_SIZE);
+    memcpy(out, "LSNP", 4);
+    put16(out + 4, VERSION);
+    put16(out + 6, life.getWrapAround() ? 1 : 0);
+    put32(out + 8, life.getWidth());
+    put32(out + 12, life.getHeight());
+    put16(out + 16, BIRTH_B3);
+    put16(out + 18, SURVIVAL_S23);
+    put32(out + 20, life.getGenerationCount());
+    put32(out + 24, life.getMaxGenerations());
+    put32(out + 28, life.getFinalPeriod());
+    put32(out + 32, life.getSeed());
+
+    unsigned long history[GameOfLife::HISTORY_SIZE];
+    int count = life.getHistory(history);
+    // Keep the most recent hashes if the history ever outgrows the header
+    int first = count > MAX_HISTORY ? count - MAX_HISTORY : 0;
+    out[36] = sizeof(unsigned long) * 8;
+    out[37] = count - first;
+    for (int i = first; i < count; i++)
+        put64(out + 40 + 8 * (i - first), history[i]);
+
+    uint8_t *p = out + HEADER_SIZE;
+    for (int y = 0; y < life.getHeight(); y++)
+    {
+        const uint64_t *row = life.getRow(y);
+        for (int w = 0; w < life.getWordsPerRow(); w++, p += 8)
+            put64(p, row[w]);
+    }
+    put32(p, crc32(out, p - out));
+    return total;
+}
+
+void LifeSnapshot::save(const GameOfLife &life, LifeVector<uint8_t> &out)
+{
+    out.resize(size(life));
+    save(life, out.data(), out.size());
+}
+
+bool LifeSnapshot::readHeader(const uint8_t *data, size_t len, Header &header)
+{
+    if (len < HEADER_SIZE || memcmp(data, "LSNP", 4) != 0)
+        return false;
+    header.version = get16(data + 4);
+    if (header.version != VERSION)
+        return false;
+
+    header.wrapAround = get16(data + 6) & 1;
+    header.width = get32(data + 8);
+    header.height = get32(data + 12);
+    header.birthMask = get16(data + 16);
+    header.survivalMask = get16(data + 18);
+    header.generation = get32(data + 20);
+    header.maxGenerations = get32(data + 24);
+    header.finalPeriod = get32(data + 28);
+    header.seed = get32(data + 32);
+    header.hashBits = data[36];
+    header.historyCount = data[37];
+    if (!GameOfLife::validSize(header.width, header.height) || header.historyCount > MAX_HISTORY)
+        return false;
+    for (int i = 0; i < MAX_HISTORY; i++)
+        header.history[i] = get64(data + 40 + 8 * i);
+    return (uint64_t)len == size(header.width, header.height);
+}
+
+bool LifeSnapshot::restore(GameOfLife &life, const uint8_t *data, size_t len)
+{
+    Header header;
+    if (!readHeader(data, len, header))
+        return false;
+    // GameOfLife only runs B3/S23
+    if (header.birthMask != BIRTH_B3 || header.survivalMask != SURVIVAL_S23)
+        return false;
+    if ((int)header.width != life.getWidth() || (int)header.height != life.getHeight() ||
+        header.wrapAround != life.getWrapAround())
+        return false;
+    if (get32(data + len - 4) != crc32(data, len - 4))
+        return false;
+
+    LifeVector<uint64_t> row(header.wordsPerRow());
+    const uint8_t *p = data + HEADER_SIZE;
+    for (uint32_t y = 0; y < header.height; y++)
+    {
+        for (uint32_t w = 0; w < header.wordsPerRow(); w++, p += 8)
+            row[w] = get64(p);
+        life.setRow(y, row.data());
+    }
+
+    // A 32-bit hash never matches a 64-bit one, so start the history afresh
+    unsigned long history[MAX_HISTORY];
+    int count = header.hashBits == sizeof(unsigned long) * 8 ? header.historyCount : 0;
+    for (int i = 0; i < count; i++)
+        history[i] = header.history[i];
+    life.restoreState(header.generation, header.maxGenerations, header.finalPeriod,
+                      header.seed, history, count);
+    return true;
+}
+
+#ifdef ESP32
+
+bool LifeSnapshot::saveFile(const GameOfLife &life, const char *path)
+{
+    LifeVector<uint8_t> buf;
+    save(life, buf);
+    File f = SPIFFS.open(path, FILE_WRITE);
+    if (!f)
+        return false;
+    size_t written = f.write(buf.data(), buf.size());
+    f.close();
+    return written == buf.size();
+}
+
+bool LifeSnapshot::loadFile(GameOfLife &life, const char *path)
+{
+    File f = SPIFFS.open(path, FILE_READ);
+    if (!f)
+        return false;
+    // Anything else is rejected by restore() anyway; don't allocate for it
+    if (f.size() != size(life))
+    {
+        f.close();
+        return false;
+    }
+    LifeVector<uint8_t> buf(f.size());
+    size_t got = f.read(buf.data(), buf.size());
+    f.close();
+    return got == buf.size() && restore(life, buf.data(), buf.size());
+}
+
+bool LifeSnapshot::saveNvs(const GameOfLife &life, const char *key)
+{
+    TRACE_SCOPE(TRACE_SNAPSHOT);
+    LifeVector<uint8_t> buf;
+    save(life, buf);
+    Preferences prefs;
+    if (!prefs.begin("life", false))
+        return false;
+    size_t written = prefs.putBytes(key, buf.data(), buf.size());
+    prefs.end();
+    return written == buf.size();
+}
+
+bool LifeSnapshot::loadNvs(GameOfLife &life, const char *key)
+{
+    Preferences prefs;
+    if (!prefs.begin("life", true))
+        return false;
+    if (prefs.getBytesLength(key) != size(life))
+    {
+        prefs.end();
+        return false;
+    }
+    LifeVector<uint8_t> buf(size(life));
+    size_t got = prefs.getBytes(key, buf.data(), buf.size());
+    prefs.end();
+    return got > 0 && got == buf.size() && restore(life, buf.data(), buf.size());
+}
+
+#else
+
+bool LifeSnapshot::saveFile(const GameOfLife &life, const char *path)
+{
+    LifeVector<uint8_t> buf;
+    save(life, buf);
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+    return fclose(f) == 0 && ok;
+}
+
+bool LifeSnapshot::loadFile(GameOfLife &life, const char *path)
+{
+    MappedSnapshot snap;
+    return snap.open(path) && snap.restore(life);
+}
+
+MappedSnapshot::~MappedSnapshot()
+{
+    close();
+}
+
+bool MappedSnapshot::open(const char *path)
+{
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)LifeSnapshot::HEADER_SIZE)
+    {
+        ::close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    data = (const uint8_t *)map;
+    length = st.st_size;
+    if (!LifeSnapshot::readHeader(data, length, head))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedSnapshot::close()
+{
+    if (data)
+        munmap((void *)data, length);
+    data = nullptr;
+    length = 0;
+}
+
+// Straight from the mapping; the file is little endian like every host we build for
+const uint64_t *MappedSnapshot::getRow(int y) const
+{
+    if (!data || y < 0 || y >= (int)head.height)
+        return nullptr;
+    return (const uint64_t *)(data + LifeSnapshot::HEADER_SIZE) + (size_t)y * head.wordsPerRow();
+}
+
+bool MappedSnapshot::getCell(int x, int y) const
+{
+    const uint64_t *row = getRow(y);
+    if (!row || x < 0 || x >= (int)head.width)
+        return false;
+    return (row[x / 64] >> (x % 64)) & 1;
+}
+
+bool MappedSnapshot::restore(GameOfLife &life) const
+{
+    return data && LifeSnapshot::restore(life, data, length);
+}
+
+#endif
@@ -0,0 +1,111 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "life.h"
+
+// Versioned binary snapshot of a GameOfLife: the packed cells plus what it
+// takes to carry on exactly where it left off (generation count, limits,
+// history hashes, seed).
+//
+// Layout, little endian throughout:
+//    0  'L' 'S' 'N' 'P'
+//    4  uint16 version, uint16 flags (bit 0 = wrap-around)
+//    8  uint32 width, uint32 height
+//   16  uint16 birth mask, uint16 survival mask (bit n = n neighbours)
+//   20  uint32 generation, max generations, final period, seed
+//   36  uint8 hash bits, uint8 history count, uint16 reserved
+//   40  MAX_HISTORY x uint64 history hashes, oldest first
+//  168  height x wordsPerRow x uint64 packed rows, as GameOfLife::getRow()
+//  end  uint32 CRC-32 of everything before it
+//
+// Rows start 8-byte aligned, so a mapped file can be read in place.
+class LifeSnapshot
+{
+public:
+    static const uint16_t VERSION = 1;
+    static const int MAX_HISTORY = 16;
+    static const size_t HEADER_SIZE = 168;
+    static const uint16_t BIRTH_B3 = 1 << 3;
+    static const uint16_t SURVIVAL_S23 = (1 << 2) | (1 << 3);
+
+    struct Header
+    {
+        uint16_t version;
+        bool wrapAround;
+        uint32_t width;
+        uint32_t height;
+        uint16_t birthMask;
+        uint16_t survivalMask;
+        uint32_t generation;
+        uint32_t maxGenerations;
+        uint32_t finalPeriod;
+        uint32_t seed;
+        uint8_t hashBits; // Width of unsigned long where the history was taken
+        uint8_t historyCount;
+        uint64_t history[MAX_HISTORY];
+
+        uint32_t wordsPerRow() const { return (width + 63) / 64; }
+    };
+
+    // Bytes needed for a snapshot of this board. In 64 bits, so a header's
+    // dimensions cannot wrap it round to a small value.
+    static size_t size(const GameOfLife &life);
+    static constexpr uint64_t size(uint32_t width, uint32_t height)
+    {
+        return HEADER_SIZE + (uint64_t)height * (((uint64_t)width + 63) / 64) * 8 + 4;
+    }
+    // Arena space (LIFE_STATIC_MEMORY) for saving or loading a w x h snapshot
+    static constexpr size_t arenaBytes(uint32_t width, uint32_t height)
+    {
+        return LifeArena::blockBytes(size(width, height)) + LifeArena::blockBytes((width + 63) / 64 * 8);
+    }
+    // Bytes written, or 0 if `capacity` is too small
+    static size_t save(const GameOfLife &life, uint8_t *out, size_t capacity);
+    static void save(const GameOfLife &life, LifeVector<uint8_t> &out);
+
+    // Checks the magic, version, that the dimensions make a board
+    // (GameOfLife::validSize()) and the length against them; not the CRC
+    static bool readHeader(const uint8_t *data, size_t len, Header &header);
+    // Needs a board of the same size and wrap mode. History hashes only come
+    // back when they were taken with the same hash width.
+    static bool restore(GameOfLife &life, const uint8_t *data, size_t len);
+
+    // SPIFFS on the ESP32 (mounted by the caller), the file system on a host
+    static bool saveFile(const GameOfLife &life, const char *path);
+    static bool loadFile(GameOfLife &life, const char *path);
+#ifdef ESP32
+    // One blob per key in the "life" NVS namespace
+    static bool saveNvs(const GameOfLife &life, const char *key);
+    static bool loadNvs(GameOfLife &life, const char *key);
+#endif
+
+    static uint32_t crc32(const uint8_t *data, size_t len);
+};
+
+#ifndef ESP32
+// A snapshot file mapped read-only. Rows are read straight from the page
+// cache, so a large board can be inspected without copying it; restore()
+// checks the CRC as it copies.
+class MappedSnapshot
+{
+public:
+    MappedSnapshot() {}
+    ~MappedSnapshot();
+
+    bool open(const char *path);
+    void close();
+
+    const LifeSnapshot::Header &header() const { return head; }
+    const uint64_t *getRow(int y) const;
+    bool getCell(int x, int y) const;
+    bool restore(GameOfLife &life) const;
+
+private:
+    const uint8_t *data = nullptr;
+    size_t length = 0;
+    LifeSnapshot::Header head;
+
+    MappedSnapshot(const MappedSnapshot &);
+    MappedSnapshot &operator=(const MappedSnapshot &);
+};
+#endif
@@ -0,0 +1,136 @@
+#include "LifeTrace.h"
+
+#if LIFE_TRACE
+#include <stdio.h>
+#include <atomic>
+
+#ifdef ESP32
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <chrono>
+#endif
+
+struct TraceEvent
+{
+    std::atomic<uint32_t> seq; // Its index + 1 once written, 0 while being written
+    uint32_t timeUs;
+    uint32_t arg;
+    uint8_t id;
+    char phase;
+    uint8_t core;
+};
+
+static const uint32_t MASK = LIFE_TRACE_EVENTS - 1;
+static_assert((LIFE_TRACE_EVENTS & MASK) == 0, "LIFE_TRACE_EVENTS must be a power of two");
+
+static TraceEvent ring[LIFE_TRACE_EVENTS];
+static std::atomic<uint32_t> head(0);
+static std::atomic<bool> enabled(true);
+
+// No spaces: lifetrace reads them as words
+static const char *const NAMES[TRACE_ID_COUNT] = {
+    "loop", "wifi", "wifi-response", "network", "viewer", "scroll", "scroll-callback",
+    "draw", "advance", "step", "stepN", "finish-check", "effect", "new-game",
+    "compose", "panel-flush", "broadcast", "snapshot", "idle", "screen-batch",
+};
+
+static uint32_t nowUs()
+{
+#ifdef ESP32
+    return (uint32_t)esp_timer_get_time();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+static uint8_t coreId()
+{
+#ifdef ESP32
+    return (uint8_t)xPortGetCoreID();
+#else
+    // Threads stand in for cores, numbered as they first record
+    static std::atomic<uint8_t> threads(0);
+    thread_local uint8_t id = threads++;
+    return id;
+#endif
+}
+
+void LifeTrace::record(TraceId id, Phase phase, uint32_t arg)
+{
+    if (!enabled.load(std::memory_order_relaxed))
+        return;
+    uint32_t i = head.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent &e = ring[i & MASK];
+    // A dump that meets the slot half written skips it
+    e.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.timeUs = nowUs();
+    e.arg = arg;
+    e.id = id;
+    e.phase = phase;
+    e.core = coreId();
+    e.seq.store(i + 1, std::memory_order_release);
+}
+
+void LifeTrace::setEnabled(bool on)
+{
+    enabled.store(on);
+}
+
+bool LifeTrace::isEnabled()
+{
+    return enabled.load();
+}
+
+uint32_t LifeTrace::getRecorded()
+{
+    return head.load();
+}
+
+const char *LifeTrace::name(TraceId id)
+{
+    return id < TRACE_ID_COUNT ? NAMES[id] : "?";
+}
+
+uint32_t LifeTrace::dump(Writer write, void *context)
+{
+    bool was = enabled.exchange(false);
+    uint32_t end = head.load(std::memory_order_acquire);
+    uint32_t start = end > LIFE_TRACE_EVENTS ? end - LIFE_TRACE_EVENTS : 0;
+
+    // Lines are gathered so the writer sees a few large pieces
+    char buf[512];
+    int used = snprintf(buf, sizeof(buf), "# lifetrace 1, %u events recorded\n", (unsigned)end);
+    uint32_t written = 0;
+    for (uint32_t i = start; i != end; i++)
+    {
+        TraceEvent &e = ring[i & MASK];
+        uint32_t seq = e.seq.load(std::memory_order_acquire);
+        uint32_t timeUs = e.timeUs, arg = e.arg;
+        uint8_t id = e.id, core = e.core;
+        char phase = e.phase;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq != i + 1 || e.seq.load(std::memory_order_relaxed) != seq)
+            continue;
+
+        if (used > (int)sizeof(buf) - 64)
+        {
+            write(context, buf, used);
+            used = 0;
+        }
+        // time_us core phase name arg
+        used += snprintf(buf + used, sizeof(buf) - used, "%u %u %c %s %u\n", (unsigned)timeUs, (unsigned)core,
+                         phase, name((TraceId)id), (unsigned)arg);
+        written++;
+    }
+    used += snprintf(buf + used, sizeof(buf) - used, "# end, %u events, %u lost\n", (unsigned)written,
+                     (unsigned)(end - written));
+    write(context, buf, used);
+    enabled.store(was);
+    return written;
+}
+#endif
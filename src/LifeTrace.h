@@ -0,0 +1,96 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// A timeline of what the firmware was doing, for seeing how stages land
+// against each other rather than only their totals. Loop stages, the
+// scroll callback, effects, engine steps and the soup screener record
+// begin and end events, stamped in microseconds with the core that ran
+// them.
+//
+// Built in with -DLIFE_TRACE=1 (env:esp32dev_trace); otherwise the TRACE_
+// macros compile to nothing. Events go into a fixed ring of
+// LIFE_TRACE_EVENTS, the oldest overwritten first. Taking a slot is one
+// atomic add, so both cores record without a lock and never wait.
+//
+// dump() writes the ring as text, for GET /trace or the serial port;
+// lifetrace turns that into Chrome trace JSON for ui.perfetto.dev or
+// chrome://tracing.
+#ifndef LIFE_TRACE
+#define LIFE_TRACE 0
+#endif
+#ifndef LIFE_TRACE_EVENTS
+#define LIFE_TRACE_EVENTS 1024 // A power of two; 16 bytes each
+#endif
+
+enum TraceId : uint8_t
+{
+    TRACE_LOOP, // A loop() pass starts
+    TRACE_WIFI, // handleWiFi(); arg is its state
+    TRACE_WIFI_RESPONSE,
+    TRACE_NETWORK,
+    TRACE_VIEWER,
+    TRACE_SCROLL,
+    TRACE_SCROLL_CALLBACK, // arg is the scroll state
+    TRACE_DRAW,
+    TRACE_ADVANCE,
+    TRACE_STEP, // arg is the generation
+    TRACE_STEP_N, // arg is the generations asked for
+    TRACE_FINISH_CHECK,
+    TRACE_EFFECT, // arg is which
+    TRACE_NEW_GAME,
+    TRACE_COMPOSE,
+    TRACE_PANEL_FLUSH,
+    TRACE_BROADCAST,
+    TRACE_SNAPSHOT,
+    TRACE_IDLE,
+    TRACE_SCREEN_BATCH,
+    TRACE_ID_COUNT
+};
+
+class LifeTrace
+{
+public:
+    enum Phase : char
+    {
+        BEGIN = 'B',
+        END = 'E',
+        MARK = 'I' // A moment rather than a span
+    };
+
+    // Receives the dump a piece at a time
+    typedef void (*Writer)(void *context, const char *text, size_t len);
+
+    static void record(TraceId id, Phase phase, uint32_t arg = 0);
+    // Recording starts enabled
+    static void setEnabled(bool on);
+    static bool isEnabled();
+    // Since start up, including events since overwritten
+    static uint32_t getRecorded();
+    static const char *name(TraceId id);
+
+    // Oldest first, one event per line; recording pauses meanwhile.
+    // Returns the events written.
+    static uint32_t dump(Writer write, void *context);
+};
+
+// Begins now and ends when it goes out of scope
+class LifeTraceScope
+{
+public:
+    LifeTraceScope(TraceId traceId, uint32_t arg = 0) : id(traceId) { LifeTrace::record(id, LifeTrace::BEGIN, arg); }
+    ~LifeTraceScope() { LifeTrace::record(id, LifeTrace::END); }
+
+private:
+    TraceId id;
+};
+
+#if LIFE_TRACE
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_SCOPE(...) LifeTraceScope TRACE_JOIN(traceScope, __LINE__)(__VA_ARGS__)
+#define TRACE_MARK(id, arg) LifeTrace::record(id, LifeTrace::MARK, arg)
+#else
+#define TRACE_SCOPE(...)
+#define TRACE_MARK(id, arg)
+#endif
@@ -0,0 +1,532 @@
+#include "LifeViewer.h"
+#include "LifeRecording.h"
+#include "LifeTrace.h"
+#include "LoopScheduler.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#ifdef ESP32
+#include <lwip/sockets.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL; // A viewer closing mid-send is not fatal
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+// SHA-1 of the handshake key, as RFC 6455 needs; nothing else uses it
+static void sha1(const uint8_t *data, size_t len, uint8_t digest[20])
+{
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint8_t block[64];
+    uint64_t bits = (uint64_t)len * 8;
+    // Message, 0x80, zero padding, then the bit length in the last 8 bytes
+    size_t total = (len + 9 + 63) / 64 * 64;
+    for (size_t at = 0; at < total; at += 64)
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            size_t k = at + i;
+            if (k < len)
+                block[i] = data[k];
+            else if (k == len)
+                block[i] = 0x80;
+            else if (k >= total - 8)
+                block[i] = bits >> (8 * (total - 1 - k));
+            else
+                block[i] = 0;
+        }
+
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++)
+            w[i] = (uint32_t)block[4 * i] << 24 | block[4 * i + 1] << 16 | block[4 * i + 2] << 8 | block[4 * i + 3];
+        for (int i = 16; i < 80; i++)
+        {
+            uint32_t x = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+            w[i] = x << 1 | x >> 31;
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++)
+        {
+            uint32_t f, k;
+            if (i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = (a << 5 | a >> 27) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = b << 30 | b >> 2;
+            b = a;
+            a = t;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    for (int i = 0; i < 20; i++)
+        digest[i] = h[i / 4] >> (24 - 8 * (i % 4));
+}
+
+static void base64(const uint8_t *data, size_t len, char *out)
+{
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i = 0;
+    for (; i + 2 < len; i += 3)
+    {
+        uint32_t v = data[i] << 16 | data[i + 1] << 8 | data[i + 2];
+        for (int j = 0; j < 4; j++)
+            *out++ = digits[(v >> (18 - 6 * j)) & 63];
+    }
+    if (i < len)
+    {
+        uint32_t v = data[i] << 16 | (i + 1 < len ? data[i + 1] << 8 : 0);
+        *out++ = digits[v >> 18];
+        *out++ = digits[(v >> 12) & 63];
+        *out++ = i + 1 < len ? digits[(v >> 6) & 63] : '=';
+        *out++ = '=';
+    }
+    *out = '\0';
+}
+
+static void put16(LifeVector<uint8_t> &out, uint16_t v)
+{
+    out.push_back(v);
+    out.push_back(v >> 8);
+}
+
+static void put32(LifeVector<uint8_t> &out, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        out.push_back(v >> (8 * i));
+}
+
+static void setNonBlocking(int sock)
+{
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+}
+
+LifeViewer::LifeViewer(uint16_t port, int w, int h, int count)
+    : port(port), width(w), height(h), wordsPerRow((w + 63) / 64),
+      viewerCount(count < MAX_VIEWERS ? count : MAX_VIEWERS), listener(-1),
+      framesSent(0), framesSkipped(0), bytesSent(0)
+{
+    // Everything at its largest up front
+    previous.assign((size_t)wordsPerRow * height, 0);
+    delta.reserve(messageBytes(w, h));
+    keyframe.reserve(messageBytes(w, h));
+    for (int i = 0; i < viewerCount; i++)
+    {
+        viewers[i].sock = -1;
+        viewers[i].state = V_FREE;
+        viewers[i].backlog.reserve(messageBytes(w, h));
+    }
+}
+
+LifeViewer::~LifeViewer()
+{
+    end();
+}
+
+bool LifeViewer::begin()
+{
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0)
+        return false;
+
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener, viewerCount) < 0)
+    {
+        end();
+        return false;
+    }
+    setNonBlocking(listener);
+    return true;
+}
+
+void LifeViewer::end()
+{
+    for (int i = 0; i < viewerCount; i++)
+        drop(viewers[i]);
+    if (listener >= 0)
+    {
+        close(listener);
+        listener = -1;
+    }
+}
+
+int LifeViewer::getViewerCount() const
+{
+    int n = 0;
+    for (int i = 0; i < viewerCount; i++)
+        n += viewers[i].state == V_OPEN;
+    return n;
+}
+
+bool LifeViewer::needsKeyframe() const
+{
+    for (int i = 0; i < viewerCount; i++)
+    {
+        if (viewers[i].state == V_OPEN && viewers[i].needsKeyframe)
+            return true;
+    }
+    return false;
+}
+
+void LifeViewer::watch(LoopScheduler &sched) const
+{
+    sched.watch(listener);
+    for (int i = 0; i < viewerCount; i++)
+    {
+        const Viewer &v = viewers[i];
+        if (v.state == V_FREE)
+            continue;
+        sched.watch(v.sock);
+        if (v.backlogSent < v.backlog.size())
+            sched.watch(v.sock, true);
+    }
+}
+
+void LifeViewer::drop(Viewer &v)
+{
+    if (v.sock >= 0)
+        close(v.sock);
+    v.sock = -1;
+    v.state = V_FREE;
+}
+
+void LifeViewer::service()
+{
+    TRACE_SCOPE(TRACE_VIEWER);
+    if (listener < 0)
+        return;
+    accept();
+    for (int i = 0; i < viewerCount; i++)
+    {
+        Viewer &v = viewers[i];
+        if (v.state == V_HANDSHAKE)
+            readHandshake(v);
+        else if (v.state == V_OPEN)
+        {
+            readFrames(v);
+            if (v.state == V_OPEN)
+                flushBacklog(v);
+        }
+    }
+}
+
+void LifeViewer::accept()
+{
+    for (int i = 0; i < viewerCount; i++)
+    {
+        Viewer &v = viewers[i];
+        if (v.state != V_FREE)
+            continue;
+        int s = ::accept(listener, nullptr, nullptr);
+        if (s < 0)
+            return;
+        setNonBlocking(s);
+        int one = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        v.sock = s;
+        v.state = V_HANDSHAKE;
+        v.requestLen = 0;
+        v.needsKeyframe = true;
+        v.backlog.clear();
+        v.backlogSent = 0;
+    }
+}
+
+void LifeViewer::readHandshake(Viewer &v)
+{
+    int n = recv(v.sock, v.request + v.requestLen, REQUEST_SIZE - 1 - v.requestLen, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+    {
+        drop(v);
+        return;
+    }
+    if (n > 0)
+        v.requestLen += n;
+    v.request[v.requestLen] = '\0';
+    char *end = strstr(v.request, "\r\n\r\n");
+    if (!end)
+    {
+        // Headers too long for the buffer
+        if (v.requestLen >= REQUEST_SIZE - 1)
+            drop(v);
+        return;
+    }
+    // A client may send its first frames straight after the headers; they
+    // stay in the buffer for readFrames(), and the search stops short of them
+    int headersLen = end + 4 - v.request;
+    end[2] = '\0';
+
+    // Find the key, case-insensitively, and answer with its accept value
+    const char *key = nullptr;
+    for (const char *line = v.request; line; line = strstr(line, "\r\n"))
+    {
+        while (*line == '\r' || *line == '\n')
+            line++;
+        if (strncasecmp(line, "Sec-WebSocket-Key:", 18) == 0)
+        {
+            key = line + 18;
+            break;
+        }
+    }
+    if (!key)
+    {
+        static const char refusal[] = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n";
+        send(v.sock, refusal, sizeof(refusal) - 1, SEND_FLAGS);
+        drop(v);
+        return;
+    }
+    while (*key == ' ')
+        key++;
+    char accept[96];
+    size_t keyLen = strcspn(key, " \r\n");
+    if (keyLen > 32)
+    {
+        drop(v);
+        return;
+    }
+    static const char guid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    memcpy(accept, key, keyLen);
+    memcpy(accept + keyLen, guid, sizeof(guid) - 1);
+    uint8_t digest[20];
+    sha1((const uint8_t *)accept, keyLen + sizeof(guid) - 1, digest);
+    base64(digest, sizeof(digest), accept);
+
+    char response[160];
+    int len = snprintf(response, sizeof(response),
+                       "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                       "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n",
+                       accept);
+    // Small enough to go in one send on a fresh connection
+    if (send(v.sock, response, len, SEND_FLAGS) != len)
+    {
+        drop(v);
+        return;
+    }
+    v.state = V_OPEN;
+    memmove(v.request, v.request + headersLen, v.requestLen - headersLen);
+    v.requestLen -= headersLen;
+}
+
+// Viewers only send control frames; answer a close, ignore the rest
+void LifeViewer::readFrames(Viewer &v)
+{
+    int n = recv(v.sock, v.request + v.requestLen, REQUEST_SIZE - v.requestLen, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+    {
+        drop(v);
+        return;
+    }
+    if (n > 0)
+        v.requestLen += n;
+
+    const uint8_t *p = (const uint8_t *)v.request;
+    int at = 0;
+    while (v.requestLen - at >= 2)
+    {
+        int opcode = p[at] & 0x0F;
+        size_t len = p[at + 1] & 0x7F;
+        int header = 2 + ((p[at + 1] & 0x80) ? 4 : 0);
+        if (len == 127)
+        {
+            drop(v);
+            return;
+        }
+        if (len == 126)
+        {
+            if (v.requestLen - at < 4)
+                break;
+            len = p[at + 2] << 8 | p[at + 3];
+            header += 2;
+        }
+        // A frame must fit the buffer whole, or it could never be read
+        if (header + len > (size_t)REQUEST_SIZE)
+        {
+            drop(v);
+            return;
+        }
+        if ((size_t)(v.requestLen - at) < header + len)
+            break;
+        if (opcode == 0x8)
+        {
+            static const uint8_t closing[] = {0x88, 0x00};
+            send(v.sock, closing, sizeof(closing), SEND_FLAGS);
+            drop(v);
+            return;
+        }
+        at += header + len;
+    }
+    memmove(v.request, v.request + at, v.requestLen - at);
+    v.requestLen -= at;
+}
+
+// True once nothing is left waiting
+bool LifeViewer::flushBacklog(Viewer &v)
+{
+    if (v.backlogSent == v.backlog.size())
+        return true;
+    int n = send(v.sock, v.backlog.data() + v.backlogSent, v.backlog.size() - v.backlogSent, SEND_FLAGS);
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        drop(v);
+        return false;
+    }
+    if (n > 0)
+    {
+        v.backlogSent += n;
+        bytesSent += n;
+    }
+    return v.backlogSent == v.backlog.size();
+}
+
+void LifeViewer::sendMessage(Viewer &v, const LifeVector<uint8_t> &msg)
+{
+    int n = send(v.sock, msg.data(), msg.size(), SEND_FLAGS);
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        drop(v);
+        return;
+    }
+    if (n <= 0)
+    {
+        // Nothing went: the stream is intact, but this frame is missed
+        v.needsKeyframe = true;
+        framesSkipped++;
+        return;
+    }
+    bytesSent += n;
+    if ((size_t)n < msg.size())
+    {
+        // A message has to finish before the next one can start
+        v.backlog.assign(msg.begin() + n, msg.end());
+        v.backlogSent = 0;
+    }
+    v.needsKeyframe = false;
+    framesSent++;
+}
+
+// Room for the longest header; endMessage() closes the gap
+static const size_t WS_HEADER_MAX = 10;
+
+void LifeViewer::beginMessage(LifeVector<uint8_t> &msg)
+{
+    msg.assign(WS_HEADER_MAX, 0);
+}
+
+void LifeViewer::endMessage(LifeVector<uint8_t> &msg)
+{
+    size_t len = msg.size() - WS_HEADER_MAX;
+    size_t header = len < 126 ? 2 : len < 65536 ? 4 : 10;
+    uint8_t *h = msg.data() + WS_HEADER_MAX - header;
+    h[0] = 0x82; // Final fragment, binary
+    if (header == 2)
+        h[1] = len;
+    else if (header == 4)
+    {
+        h[1] = 126;
+        h[2] = len >> 8;
+        h[3] = len;
+    }
+    else
+    {
+        h[1] = 127;
+        for (int i = 0; i < 8; i++)
+            h[2 + i] = (uint64_t)len >> (56 - 8 * i);
+    }
+    msg.erase(msg.begin(), msg.begin() + (WS_HEADER_MAX - header));
+}
+
+void LifeViewer::broadcast(const uint64_t *rows, uint32_t frame)
+{
+    TRACE_SCOPE(TRACE_BROADCAST, frame);
+    size_t words = (size_t)wordsPerRow * height;
+    bool wantKeyframe = false;
+    bool wantDelta = false;
+    for (int i = 0; i < viewerCount; i++)
+    {
+        if (viewers[i].state == V_OPEN)
+        {
+            wantKeyframe |= viewers[i].needsKeyframe;
+            wantDelta |= !viewers[i].needsKeyframe;
+        }
+    }
+
+    // Each encoded once, whatever the number of viewers
+    if (wantKeyframe)
+    {
+        beginMessage(keyframe);
+        keyframe.push_back('K');
+        put16(keyframe, width);
+        put16(keyframe, height);
+        put32(keyframe, frame);
+        LifeRecorder::encodeRuns(keyframe, (const uint8_t *)rows, words * sizeof(uint64_t));
+        endMessage(keyframe);
+    }
+    if (wantDelta)
+    {
+        for (size_t i = 0; i < words; i++)
+            previous[i] ^= rows[i];
+        beginMessage(delta);
+        delta.push_back('D');
+        put32(delta, frame);
+        LifeRecorder::encodeRuns(delta, (const uint8_t *)previous.data(), words * sizeof(uint64_t));
+        endMessage(delta);
+    }
+    memcpy(previous.data(), rows, words * sizeof(uint64_t));
+
+    for (int i = 0; i < viewerCount; i++)
+    {
+        Viewer &v = viewers[i];
+        if (v.state != V_OPEN)
+            continue;
+        if (!flushBacklog(v))
+        {
+            // Still busy with an older frame
+            if (v.state == V_OPEN)
+            {
+                v.needsKeyframe = true;
+                framesSkipped++;
+            }
+            continue;
+        }
+        sendMessage(v, v.needsKeyframe ? keyframe : delta);
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "LifeArena.h"
+
+class LoopScheduler;
+
+// Pushes the panel to browsers over WebSocket, one binary message per frame.
+// Each message is encoded once and the same buffer is sent to every viewer.
+//
+//   'K' uint16 width, uint16 height, uint32 frame, packed rows run-length coded
+//   'D' uint32 frame, packed rows XOR the previous frame, run-length coded
+//
+// Little endian; rows and run-length coding as LifeRecorder. A viewer gets a
+// keyframe when it connects and after any frame it had to miss; a viewer
+// that cannot keep up is skipped rather than holding up the others.
+class LifeViewer
+{
+public:
+    static const int MAX_VIEWERS = 8;
+    static const int REQUEST_SIZE = 512; // Handshake or incoming frame
+
+    LifeViewer(uint16_t port, int width, int height, int viewers = 4);
+    ~LifeViewer();
+
+    // Largest message for a w x h board, WebSocket header included
+    static constexpr size_t messageBytes(int w, int h) { return 2 * ((size_t)(w + 63) / 64 * h * 8) + 48; }
+    // Arena space (LIFE_STATIC_MEMORY) for a w x h board
+    static constexpr size_t arenaBytes(int w, int h, int viewers)
+    {
+        return LifeArena::blockBytes((size_t)(w + 63) / 64 * h * 8) +
+               (2 + viewers) * LifeArena::blockBytes(messageBytes(w, h));
+    }
+
+    bool begin();
+    void end();
+    // Accept viewers, answer handshakes and closes, finish backed up sends
+    void service();
+    // Send a frame of wordsPerRow x height packed rows to every viewer
+    void broadcast(const uint64_t *rows, uint32_t frame);
+    // The sockets service() has to look at next
+    void watch(LoopScheduler &sched) const;
+
+    int getViewerCount() const;
+    // Someone is waiting for a keyframe, so send a frame even if nothing changed
+    bool needsKeyframe() const;
+    uint32_t getFramesSent() const { return framesSent; }
+    uint32_t getFramesSkipped() const { return framesSkipped; }
+    uint64_t getBytesSent() const { return bytesSent; }
+
+private:
+    enum ViewerState
+    {
+        V_FREE,
+        V_HANDSHAKE,
+        V_OPEN
+    };
+
+    struct Viewer
+    {
+        int sock;
+        ViewerState state;
+        char request[REQUEST_SIZE];
+        int requestLen;
+        bool needsKeyframe;
+        LifeVector<uint8_t> backlog; // Rest of a message the socket would not take
+        size_t backlogSent;
+    };
+
+    uint16_t port;
+    int width;
+    int height;
+    int wordsPerRow;
+    int viewerCount;
+    int listener;
+    Viewer viewers[MAX_VIEWERS];
+    LifeVector<uint64_t> previous;
+    LifeVector<uint8_t> delta;    // WebSocket frames, header included
+    LifeVector<uint8_t> keyframe;
+    uint32_t framesSent;
+    uint32_t framesSkipped;
+    uint64_t bytesSent;
+
+    void accept();
+    void readHandshake(Viewer &v);
+    void readFrames(Viewer &v);
+    bool flushBacklog(Viewer &v);
+    void sendMessage(Viewer &v, const LifeVector<uint8_t> &msg);
+    void drop(Viewer &v);
+    static void beginMessage(LifeVector<uint8_t> &msg);
+    static void endMessage(LifeVector<uint8_t> &msg);
+};
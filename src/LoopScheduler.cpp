@@ -0,0 +1,143 @@
+#include "LoopScheduler.h"
+#include "LifeTrace.h"
+
+#ifdef ESP32
+#include <sdkconfig.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <lwip/sockets.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+#else
+#include <chrono>
+#include <sys/select.h>
+#include <thread>
+#endif
+
+LoopScheduler::LoopScheduler()
+    : readCount(0), writeCount(0), timeoutMs(MAX_IDLE_MS), lightSleep(false), passStartUs(0),
+      awakeUs(0), idleUs(0), frames(0), unchangedFrames(0), latencyTotalMs(0), latencyMaxMs(0)
+{
+}
+
+int64_t LoopScheduler::nowUs()
+{
+#ifdef ESP32
+    return esp_timer_get_time();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+bool LoopScheduler::begin()
+{
+#if defined(ESP32) && CONFIG_PM_ENABLE
+    // The clock scales down when idle, and the CPU sleeps between the beacons
+    // the modem wakes for (WiFi's default modem sleep)
+    esp_pm_config_esp32_t pm = {};
+    pm.max_freq_mhz = 240;
+    pm.min_freq_mhz = 80;
+    pm.light_sleep_enable = true;
+    lightSleep = esp_pm_configure(&pm) == ESP_OK;
+#endif
+    passStartUs = nowUs();
+    return lightSleep;
+}
+
+void LoopScheduler::beginPass()
+{
+    readCount = writeCount = 0;
+    timeoutMs = MAX_IDLE_MS;
+}
+
+void LoopScheduler::watch(int sock, bool writable)
+{
+    if (sock < 0)
+        return;
+    if (writable && writeCount < MAX_WATCHED)
+        writeSocks[writeCount++] = sock;
+    else if (!writable && readCount < MAX_WATCHED)
+        readSocks[readCount++] = sock;
+    else
+        timeoutMs = 0; // Cannot wait on it, so poll
+}
+
+void LoopScheduler::wakeIn(uint32_t ms)
+{
+    if (ms < timeoutMs)
+        timeoutMs = ms;
+}
+
+void LoopScheduler::idle()
+{
+    TRACE_SCOPE(TRACE_IDLE, timeoutMs);
+    int64_t start = nowUs();
+    if (passStartUs)
+        awakeUs += start - passStartUs;
+
+    if (timeoutMs > 0)
+    {
+        if (readCount || writeCount)
+        {
+            fd_set readSet, writeSet;
+            FD_ZERO(&readSet);
+            FD_ZERO(&writeSet);
+            int maxSock = -1;
+            for (int i = 0; i < readCount; i++)
+            {
+                FD_SET(readSocks[i], &readSet);
+                if (readSocks[i] > maxSock)
+                    maxSock = readSocks[i];
+            }
+            for (int i = 0; i < writeCount; i++)
+            {
+                FD_SET(writeSocks[i], &writeSet);
+                if (writeSocks[i] > maxSock)
+                    maxSock = writeSocks[i];
+            }
+            struct timeval tv;
+            tv.tv_sec = timeoutMs / 1000;
+            tv.tv_usec = (timeoutMs % 1000) * 1000;
+            select(maxSock + 1, &readSet, &writeSet, nullptr, &tv);
+        }
+        else
+        {
+#ifdef ESP32
+            vTaskDelay(pdMS_TO_TICKS(timeoutMs));
+#else
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+#endif
+        }
+    }
+
+    passStartUs = nowUs();
+    idleUs += passStartUs - start;
+}
+
+void LoopScheduler::frameDone(uint32_t latencyMs, bool changed)
+{
+    frames++;
+    if (!changed)
+        unchangedFrames++;
+    latencyTotalMs += latencyMs;
+    if (latencyMs > latencyMaxMs)
+        latencyMaxMs = latencyMs;
+}
+
+uint32_t LoopScheduler::getAwakePerMille() const
+{
+    uint64_t total = awakeUs + idleUs;
+    return total ? (uint32_t)(awakeUs * 1000 / total) : 1000;
+}
+
+uint32_t LoopScheduler::getEstimatedMicroamps() const
+{
+    uint32_t awake = getAwakePerMille();
+    return (uint32_t)(((uint64_t)awake * ACTIVE_UA +
+                       (uint64_t)(1000 - awake) * (lightSleep ? LIGHT_SLEEP_UA : WAITING_UA)) /
+                      1000);
+}
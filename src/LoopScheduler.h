@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+
+// Sleeps out the rest of each loop() pass instead of spinning. During a
+// pass, each task says when it next needs to run (wakeIn()) and which
+// sockets should wake it early (watch()). idle() then waits in select()
+// for whichever comes first. While it waits, FreeRTOS idles the CPU. If
+// power management is built in, it also drops into light sleep between
+// WiFi beacons.
+//
+// Current draw is estimated from the time spent awake and idle; there is
+// no sensor. Only the ESP32 itself counts, not the panel's LEDs, and only
+// the loop task's time: other tasks, such as the soup screener, are not seen.
+class LoopScheduler
+{
+public:
+    static const uint32_t MAX_IDLE_MS = 1000;
+    // ESP32 datasheet figures: CPU running at 240 MHz with the modem
+    // asleep, CPU waiting at 240 MHz, and light sleep
+    static const uint32_t ACTIVE_UA = 68000;
+    static const uint32_t WAITING_UA = 30000;
+    static const uint32_t LIGHT_SLEEP_UA = 800;
+
+    LoopScheduler();
+
+    // Turn on automatic light sleep where the build allows it
+    bool begin();
+    bool hasLightSleep() const { return lightSleep; }
+
+    // Forget the last pass's deadline and sockets
+    void beginPass();
+    // Wake when sock is readable, or writable
+    void watch(int sock, bool writable = false);
+    // Run again within ms; 0 keeps this pass from idling at all
+    void wakeIn(uint32_t ms);
+    // Wait for the nearest deadline or a watched socket
+    void idle();
+
+    // A frame fell due latencyMs before it reached the panel; changed is
+    // false when compose() had nothing to send
+    void frameDone(uint32_t latencyMs, bool changed);
+
+    uint64_t getAwakeUs() const { return awakeUs; }
+    uint64_t getIdleUs() const { return idleUs; }
+    // Per mille of the time since begin() spent awake
+    uint32_t getAwakePerMille() const;
+    uint32_t getEstimatedMicroamps() const;
+    uint32_t getFrames() const { return frames; }
+    uint32_t getUnchangedFrames() const { return unchangedFrames; }
+    uint32_t getLatencyAvgMs() const { return frames ? latencyTotalMs / frames : 0; }
+    uint32_t getLatencyMaxMs() const { return latencyMaxMs; }
+
+private:
+    static const int MAX_WATCHED = 16;
+
+    int readSocks[MAX_WATCHED];
+    int writeSocks[MAX_WATCHED];
+    int readCount;
+    int writeCount;
+    uint32_t timeoutMs;
+    bool lightSleep;
+    int64_t passStartUs;
+    uint64_t awakeUs;
+    uint64_t idleUs;
+    uint32_t frames;
+    uint32_t unchangedFrames;
+    uint64_t latencyTotalMs;
+    uint32_t latencyMaxMs;
+
+    static int64_t nowUs();
+};
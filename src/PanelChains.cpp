@@ -0,0 +1,357 @@
+#include "PanelChains.h"
+#include <string.h>
+#include "LifeTrace.h"
+
+#ifdef ESP32
+#include <driver/gpio.h>
+#include <driver/spi_master.h>
+#include <esp_timer.h>
+#include <soc/gpio_reg.h>
+
+// One set per program: the SPI hosts cannot be shared between instances anyway
+static spi_transaction_t transactions[PanelChains::MAX_CHAINS][8];
+#endif
+
+// MAX7219 registers; digit rows are 1-8
+static const uint8_t REG_NOOP = 0x00;
+static const uint8_t REG_DECODE = 0x09;
+static const uint8_t REG_INTENSITY = 0x0A;
+static const uint8_t REG_SCAN_LIMIT = 0x0B;
+static const uint8_t REG_SHUTDOWN = 0x0C;
+static const uint8_t REG_TEST = 0x0F;
+
+PanelChains::PanelChains(const Chain *config, int count, uint32_t hz)
+    : chainCount(count < MAX_CHAINS ? count : MAX_CHAINS), moduleCount(0), spiHz(hz), sendAll(true),
+      tap(nullptr), tapContext(nullptr), lastModelNs(0), lastFlushUs(0), bitsSent(0), transfers(0)
+{
+    for (int i = 0; i < chainCount; i++)
+    {
+        ChainState &c = chains[i];
+        c.config = config[i];
+        c.first = moduleCount;
+        c.words = transferModules(config, chainCount, i);
+        c.dirty = 0xFF;
+        c.tx.assign((size_t)8 * 2 * c.words, 0);
+        c.device = nullptr;
+        moduleCount += c.config.modules;
+    }
+    rows.assign((size_t)moduleCount * 8, 0);
+    shown.assign((size_t)moduleCount * 8, 0);
+}
+
+PanelChains::~PanelChains()
+{
+#ifdef ESP32
+    for (int i = 0; i < chainCount; i++)
+    {
+        if (chains[i].device)
+            spi_bus_remove_device((spi_device_handle_t)chains[i].device);
+    }
+#endif
+}
+
+bool PanelChains::begin(uint8_t intensity)
+{
+#ifdef ESP32
+    bool hostReady[3] = {false, false, false};
+    uint32_t gpioPins = 0;
+    for (int i = 0; i < chainCount; i++)
+    {
+        ChainState &c = chains[i];
+        if (c.config.kind == CHAIN_SPI)
+        {
+            spi_host_device_t host = (spi_host_device_t)c.config.host;
+            if (c.config.host > HOST_VSPI)
+                return false;
+            if (!hostReady[c.config.host])
+            {
+                // Chains on one host share its clock and data pins, and its
+                // largest transfer
+                int largest = 0;
+                for (int j = i; j < chainCount; j++)
+                {
+                    if (chains[j].config.kind == CHAIN_SPI && chains[j].config.host == c.config.host &&
+                        chains[j].words > largest)
+                        largest = chains[j].words;
+                }
+                spi_bus_config_t bus = {};
+                bus.mosi_io_num = c.config.data;
+                bus.miso_io_num = -1;
+                bus.sclk_io_num = c.config.clk;
+                bus.quadwp_io_num = -1;
+                bus.quadhd_io_num = -1;
+                bus.max_transfer_sz = largest * 2;
+                if (spi_bus_initialize(host, &bus, SPI_DMA_CH_AUTO) != ESP_OK)
+                    return false;
+                hostReady[c.config.host] = true;
+            }
+            spi_device_interface_config_t dev = {};
+            dev.clock_speed_hz = spiHz;
+            dev.mode = 0;
+            dev.spics_io_num = c.config.cs; // Load: it latches as the transfer ends
+            dev.queue_size = 8;
+            spi_device_handle_t handle;
+            if (spi_bus_add_device(host, &dev, &handle) != ESP_OK)
+                return false;
+            c.device = handle;
+        }
+        else
+        {
+            // The output set/clear registers only reach GPIO 0-31
+            const ChainState &g = chains[i];
+            int8_t pins[3] = {g.config.clk, g.config.cs, g.config.data};
+            for (int p = 0; p < 3; p++)
+            {
+                if (pins[p] < 0 || pins[p] >= 32)
+                    return false;
+                if (!(gpioPins & (1u << pins[p])))
+                {
+                    gpio_reset_pin((gpio_num_t)pins[p]);
+                    gpio_set_direction((gpio_num_t)pins[p], GPIO_MODE_OUTPUT);
+                    gpioPins |= 1u << pins[p];
+                }
+            }
+            REG_WRITE(GPIO_OUT_W1TS_REG, 1u << g.config.cs);
+            REG_WRITE(GPIO_OUT_W1TC_REG, 1u << g.config.clk);
+        }
+    }
+#endif
+
+    // Modules power up in shutdown with random rows
+    uint8_t all[MAX_CHAINS];
+    memset(all, 1, sizeof(all));
+    send(all, REG_TEST, 0);
+    send(all, REG_SCAN_LIMIT, 7);
+    send(all, REG_DECODE, 0);
+    send(all, REG_INTENSITY, intensity);
+    clear();
+    invalidate();
+    flush();
+    send(all, REG_SHUTDOWN, 1);
+    return true;
+}
+
+int PanelChains::chainOf(int module) const
+{
+    int i = 0;
+    while (i + 1 < chainCount && module >= chains[i + 1].first)
+        i++;
+    return i;
+}
+
+void PanelChains::setRow(int module, int digit, uint8_t data)
+{
+    if (module < 0 || module >= moduleCount || digit < 0 || digit > 7)
+        return;
+    uint8_t &row = rows[module * 8 + digit];
+    if (row == data)
+        return;
+    row = data;
+    chains[chainOf(module)].dirty |= 1 << digit;
+}
+
+void PanelChains::clear()
+{
+    for (int m = 0; m < moduleCount; m++)
+    {
+        for (int d = 0; d < 8; d++)
+            setRow(m, d, 0);
+    }
+}
+
+void PanelChains::setIntensity(uint8_t intensity)
+{
+    uint8_t all[MAX_CHAINS];
+    memset(all, 1, sizeof(all));
+    send(all, REG_INTENSITY, intensity & 0x0F);
+}
+
+void PanelChains::invalidate()
+{
+    sendAll = true;
+    for (int i = 0; i < chainCount; i++)
+        chains[i].dirty = 0xFF;
+}
+
+void PanelChains::setTap(Tap t, void *context)
+{
+    tap = t;
+    tapContext = context;
+}
+
+int PanelChains::flush()
+{
+    TRACE_SCOPE(TRACE_PANEL_FLUSH);
+    // Only rows where some module differs from what it shows
+    uint8_t slots[MAX_CHAINS];
+    for (int i = 0; i < chainCount; i++)
+    {
+        ChainState &c = chains[i];
+        slots[i] = 0;
+        for (int d = 0; d < 8; d++)
+        {
+            if (!(c.dirty & (1 << d)))
+                continue;
+            bool changed = sendAll;
+            for (int m = c.first; m < c.first + c.config.modules && !changed; m++)
+                changed = rows[m * 8 + d] != shown[m * 8 + d];
+            if (changed)
+                slots[i] |= 1 << d;
+        }
+        c.dirty = 0;
+    }
+    sendAll = false;
+    int sent = send(slots, -1, 0);
+    memcpy(shown.data(), rows.data(), rows.size());
+    return sent;
+}
+
+int PanelChains::send(const uint8_t *requested, int reg, uint8_t value)
+{
+#ifdef ESP32
+    int64_t start = esp_timer_get_time();
+#endif
+    uint8_t slots[MAX_CHAINS];
+    uint8_t gpioSlots = 0;
+    for (int i = 0; i < chainCount; i++)
+    {
+        slots[i] = reg >= 0 ? (requested[i] ? 1 : 0) : requested[i];
+        if (chains[i].config.kind == CHAIN_GPIO)
+            gpioSlots |= slots[i];
+    }
+
+    // GPIO chains share their load pin, so they all latch whenever one does
+    for (int i = 0; i < chainCount; i++)
+    {
+        if (chains[i].config.kind == CHAIN_GPIO)
+            slots[i] = gpioSlots;
+    }
+
+    int count = 0;
+    uint64_t hostNs[3] = {0, 0, 0};
+    uint64_t gpioNs = 0;
+    for (int i = 0; i < chainCount; i++)
+    {
+        ChainState &c = chains[i];
+        for (int s = 0; s < 8; s++)
+        {
+            if (!(slots[i] & (1 << s)))
+                continue;
+
+            // Farthest module first; it ends up at the far end of the chain
+            uint8_t *p = &c.tx[s * 2 * c.words];
+            int pad = c.words - c.config.modules;
+            for (int w = 0; w < pad; w++)
+            {
+                *p++ = REG_NOOP;
+                *p++ = 0;
+            }
+            for (int m = c.first + c.config.modules - 1; m >= c.first; m--)
+            {
+                *p++ = reg >= 0 ? reg : s + 1;
+                *p++ = reg >= 0 ? value : rows[m * 8 + s];
+            }
+            if (tap)
+                tap(tapContext, i, &c.tx[s * 2 * c.words], 2 * c.words);
+
+            uint32_t bits = 16 * c.words;
+            bitsSent += bits;
+            count++;
+            if (c.config.kind == CHAIN_SPI)
+            {
+                hostNs[c.config.host % 3] += (uint64_t)bits * 1000000000 / spiHz + SPI_SETUP_NS;
+#ifdef ESP32
+                spi_transaction_t &t = transactions[i][s];
+                memset(&t, 0, sizeof(t));
+                t.length = bits;
+                t.tx_buffer = &c.tx[s * 2 * c.words];
+                spi_device_queue_trans((spi_device_handle_t)c.device, &t, portMAX_DELAY);
+#endif
+            }
+        }
+    }
+
+    // The GPIO chains shift while the SPI hosts run
+    for (int s = 0; s < 8; s++)
+    {
+        if (!(gpioSlots & (1 << s)))
+            continue;
+        shiftGpio(s);
+        for (int i = 0; i < chainCount; i++)
+        {
+            if (chains[i].config.kind == CHAIN_GPIO)
+            {
+                gpioNs += (uint64_t)16 * chains[i].words * GPIO_BIT_NS + GPIO_LATCH_NS;
+                break;
+            }
+        }
+    }
+
+#ifdef ESP32
+    for (int i = 0; i < chainCount; i++)
+    {
+        if (chains[i].config.kind != CHAIN_SPI)
+            continue;
+        for (int s = 0; s < 8; s++)
+        {
+            if (slots[i] & (1 << s))
+            {
+                spi_transaction_t *done;
+                spi_device_get_trans_result((spi_device_handle_t)chains[i].device, &done, portMAX_DELAY);
+            }
+        }
+    }
+    lastFlushUs = esp_timer_get_time() - start;
+#endif
+
+    uint64_t slowest = gpioNs;
+    for (int h = 0; h < 3; h++)
+    {
+        if (hostNs[h] > slowest)
+            slowest = hostNs[h];
+    }
+    lastModelNs = slowest;
+    transfers += count;
+    return count;
+}
+
+void PanelChains::shiftGpio(int slot)
+{
+#ifdef ESP32
+    const ChainState *group[MAX_CHAINS];
+    int n = 0;
+    for (int i = 0; i < chainCount; i++)
+    {
+        if (chains[i].config.kind == CHAIN_GPIO)
+            group[n++] = &chains[i];
+    }
+    uint32_t clk = 1u << group[0]->config.clk;
+    uint32_t cs = 1u << group[0]->config.cs;
+    int bytes = 2 * group[0]->words;
+
+    REG_WRITE(GPIO_OUT_W1TC_REG, cs);
+    for (int b = 0; b < bytes; b++)
+    {
+        for (int bit = 7; bit >= 0; bit--)
+        {
+            // Data changes with the clock low; the modules take it on the rising edge
+            uint32_t set = 0, reset = clk;
+            for (int i = 0; i < n; i++)
+            {
+                uint32_t pin = 1u << group[i]->config.data;
+                if ((group[i]->tx[slot * bytes + b] >> bit) & 1)
+                    set |= pin;
+                else
+                    reset |= pin;
+            }
+            REG_WRITE(GPIO_OUT_W1TC_REG, reset);
+            REG_WRITE(GPIO_OUT_W1TS_REG, set);
+            REG_WRITE(GPIO_OUT_W1TS_REG, clk);
+        }
+    }
+    REG_WRITE(GPIO_OUT_W1TC_REG, clk);
+    REG_WRITE(GPIO_OUT_W1TS_REG, cs); // Load
+#else
+    (void)slot;
+#endif
+}
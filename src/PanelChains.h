@@ -0,0 +1,141 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "LifeArena.h"
+
+// Drives the panel's MAX7219 modules as several independent daisy chains,
+// so a large display no longer shifts every register write through every
+// module. Modules are numbered as in one long chain (LedPanel's module
+// index). The first chain takes the first `modules` of them, the next chain
+// the ones after, and so on.
+//
+// A change to one digit row of one module still has to shift through its
+// whole chain; with N chains each shift is N times shorter, and the chains
+// shift at the same time:
+//   CHAIN_SPI  one per SPI host (VSPI, HSPI); each changed row is a queued
+//              DMA transfer, so both hosts run while the CPU carries on
+//   CHAIN_GPIO bit-banged, all sharing one clock and load pin with a data
+//              pin each, so every GPIO chain shifts in the same clock edges
+//
+// Rows are buffered by setRow() and sent by flush(). Data is in register
+// form: digit row 0-7 and one byte of columns, as wired on FC16 modules.
+//
+// Off the ESP32 nothing is driven. flush() still builds every transfer,
+// passes it to the tap and adds its time from the timing model below, so a
+// host can benchmark chain layouts (lifepanel).
+class PanelChains
+{
+public:
+    enum ChainKind
+    {
+        CHAIN_SPI,
+        CHAIN_GPIO
+    };
+
+    struct Chain
+    {
+        ChainKind kind;
+        uint8_t host;    // HOST_HSPI or HOST_VSPI; unused for GPIO
+        int8_t clk;      // GPIO chains share the first one's clk and cs
+        int8_t data;
+        int8_t cs;
+        uint16_t modules;
+    };
+
+    static const int MAX_CHAINS = 8;
+    static const uint8_t HOST_HSPI = 1; // ESP-IDF's SPI2_HOST
+    static const uint8_t HOST_VSPI = 2; // SPI3_HOST
+
+    // Timing model, per transfer of one digit row. SPI: queueing and load
+    // pulse on top of the clocked bits. GPIO: three register writes per bit.
+    static const uint32_t SPI_SETUP_NS = 10000;
+    static const uint32_t GPIO_BIT_NS = 250;
+    static const uint32_t GPIO_LATCH_NS = 1000;
+
+    // Called with the bytes of every transfer just before it is latched,
+    // register then data for each module, farthest module first. GPIO
+    // chains shorter than the longest one start with no-op words.
+    typedef void (*Tap)(void *context, int chain, const uint8_t *bytes, size_t len);
+
+    PanelChains(const Chain *chains, int count, uint32_t spiHz = 10000000);
+    ~PanelChains();
+
+    // Arena space (LIFE_STATIC_MEMORY) for the given chains
+    static constexpr size_t arenaBytes(const Chain *chains, int count)
+    {
+        size_t modules = 0, bytes = 0;
+        for (int i = 0; i < count; i++)
+        {
+            modules += chains[i].modules;
+            bytes += LifeArena::blockBytes((size_t)8 * 2 * transferModules(chains, count, i));
+        }
+        return bytes + 2 * LifeArena::blockBytes(modules * 8);
+    }
+    // Words in one transfer on chain i: GPIO chains all shift as far as the longest
+    static constexpr int transferModules(const Chain *chains, int count, int i)
+    {
+        int longest = chains[i].modules;
+        for (int j = 0; j < count && chains[i].kind == CHAIN_GPIO; j++)
+        {
+            if (chains[j].kind == CHAIN_GPIO && chains[j].modules > longest)
+                longest = chains[j].modules;
+        }
+        return longest;
+    }
+
+    // Set up the buses and wake the modules, blank
+    bool begin(uint8_t intensity = 0);
+    int getChainCount() const { return chainCount; }
+    int getModuleCount() const { return moduleCount; }
+
+    void setRow(int module, int digit, uint8_t data);
+    uint8_t getRow(int module, int digit) const { return rows[module * 8 + digit]; }
+    void clear();
+    void setIntensity(uint8_t intensity); // 0-15, sent straight away
+
+    // Send every digit row that changed since the last flush, all chains at
+    // once; returns when they are out. Returns the transfers made.
+    int flush();
+    // Everything again at the next flush()
+    void invalidate();
+
+    void setTap(Tap tap, void *context);
+
+    // Modelled time of the last flush(): the slowest SPI host or the GPIO group
+    uint32_t getLastModelNs() const { return lastModelNs; }
+    // Measured on the ESP32, 0 elsewhere
+    uint32_t getLastFlushUs() const { return lastFlushUs; }
+    uint64_t getBitsSent() const { return bitsSent; }
+    uint32_t getTransfers() const { return transfers; }
+
+private:
+    struct ChainState
+    {
+        Chain config;
+        int first;              // Its first module
+        int words;              // Per transfer, with any padding
+        uint8_t dirty;          // Digit rows that may need sending, one bit each
+        LifeVector<uint8_t> tx; // Eight transfers, so all can be in flight
+        void *device;           // spi_device_handle_t
+    };
+
+    ChainState chains[MAX_CHAINS];
+    int chainCount;
+    int moduleCount;
+    uint32_t spiHz;
+    LifeVector<uint8_t> rows;  // What each module should show
+    LifeVector<uint8_t> shown; // What was last sent
+    bool sendAll;              // Ignore `shown` at the next flush()
+    Tap tap;
+    void *tapContext;
+    uint32_t lastModelNs;
+    uint32_t lastFlushUs;
+    uint64_t bitsSent;
+    uint32_t transfers;
+
+    int chainOf(int module) const;
+    // One transfer per set bit of slots[chain]: digit rows, or with reg >= 0
+    // that register set to value on every module, in slot 0
+    int send(const uint8_t *slots, int reg, uint8_t value);
+    void shiftGpio(int slot);
+};
@@ -0,0 +1,188 @@
+#include "PanelCompositor.h"
+#include <string.h>
+#include "LifeTrace.h"
+
+PanelCompositor::PanelCompositor(LedPanel &p, int count)
+    : panel(p), width(p.width()), height(p.height()), wordsPerRow((p.width() + 63) / 64),
+      layerCount(count < MAX_LAYERS ? count : MAX_LAYERS), fullRedraw(true), rowsSent(0)
+{
+    for (int i = 0; i < layerCount; i++)
+    {
+        layers[i].bits.assign(wordsPerRow * height, 0);
+        layers[i].mask.assign(wordsPerRow * height, 0);
+        layers[i].op = OP_OR;
+        layers[i].visible = true;
+        layers[i].x0 = layers[i].y0 = layers[i].x1 = layers[i].y1 = 0;
+    }
+    frame.assign(wordsPerRow * height, 0);
+}
+
+void PanelCompositor::markWords(int layer, int w0, int y0, int w1, int y1)
+{
+    Layer &l = layers[layer];
+    if (l.x0 >= l.x1 || l.y0 >= l.y1)
+    {
+        l.x0 = w0;
+        l.y0 = y0;
+        l.x1 = w1;
+        l.y1 = y1;
+        return;
+    }
+    if (w0 < l.x0)
+        l.x0 = w0;
+    if (y0 < l.y0)
+        l.y0 = y0;
+    if (w1 > l.x1)
+        l.x1 = w1;
+    if (y1 > l.y1)
+        l.y1 = y1;
+}
+
+void PanelCompositor::markDirty(int layer, int x0, int y0, int x1, int y1)
+{
+    if (x0 < 0)
+        x0 = 0;
+    if (y0 < 0)
+        y0 = 0;
+    if (x1 >= width)
+        x1 = width - 1;
+    if (y1 >= height)
+        y1 = height - 1;
+    if (x0 > x1 || y0 > y1)
+        return;
+    markWords(layer, x0 / 64, y0, x1 / 64 + 1, y1 + 1);
+}
+
+int PanelCompositor::setRow(int layer, int y, const uint64_t *words)
+{
+    uint64_t *row = getRow(layer, y);
+    int changed = 0;
+    for (int w = 0; w < wordsPerRow; w++)
+    {
+        if (row[w] != words[w])
+        {
+            changed += __builtin_popcountll(row[w] ^ words[w]);
+            row[w] = words[w];
+            markWords(layer, w, y, w + 1, y + 1);
+        }
+    }
+    return changed;
+}
+
+bool PanelCompositor::setPixel(int layer, int x, int y, bool on)
+{
+    if (x < 0 || x >= width || y < 0 || y >= height)
+        return false;
+    uint64_t &word = getRow(layer, y)[x / 64];
+    uint64_t bit = (uint64_t)1 << (x % 64);
+    if (((word & bit) != 0) == on)
+        return false;
+    word ^= bit;
+    markWords(layer, x / 64, y, x / 64 + 1, y + 1);
+    return true;
+}
+
+void PanelCompositor::clearLayer(int layer)
+{
+    memset(layers[layer].bits.data(), 0, layers[layer].bits.size() * sizeof(uint64_t));
+    markWords(layer, 0, 0, wordsPerRow, height);
+}
+
+void PanelCompositor::fillLayer(int layer)
+{
+    // Bits past the last column stay clear
+    for (int y = 0; y < height; y++)
+    {
+        uint64_t *row = getRow(layer, y);
+        for (int w = 0; w < wordsPerRow; w++)
+            row[w] = width - w * 64 >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << (width - w * 64)) - 1;
+    }
+    markWords(layer, 0, 0, wordsPerRow, height);
+}
+
+void PanelCompositor::setOp(int layer, BlendOp op)
+{
+    if (layers[layer].op == op)
+        return;
+    layers[layer].op = op;
+    markWords(layer, 0, 0, wordsPerRow, height);
+}
+
+void PanelCompositor::setVisible(int layer, bool visible)
+{
+    if (layers[layer].visible == visible)
+        return;
+    layers[layer].visible = visible;
+    markWords(layer, 0, 0, wordsPerRow, height);
+}
+
+int PanelCompositor::compose()
+{
+    TRACE_SCOPE(TRACE_COMPOSE);
+    // Everything that changed in any layer, hidden ones included: hiding
+    // a layer changes what shows through
+    int x0 = wordsPerRow, y0 = height, x1 = 0, y1 = 0;
+    if (fullRedraw)
+    {
+        x0 = y0 = 0;
+        x1 = wordsPerRow;
+        y1 = height;
+    }
+    for (int i = 0; i < layerCount; i++)
+    {
+        Layer &l = layers[i];
+        if (l.x0 < l.x1 && l.y0 < l.y1)
+        {
+            if (l.x0 < x0)
+                x0 = l.x0;
+            if (l.y0 < y0)
+                y0 = l.y0;
+            if (l.x1 > x1)
+                x1 = l.x1;
+            if (l.y1 > y1)
+                y1 = l.y1;
+        }
+        l.x0 = l.y0 = l.x1 = l.y1 = 0;
+    }
+    if (x0 >= x1 || y0 >= y1)
+        return 0;
+
+    int sent = 0;
+    panel.beginFrame();
+    for (int y = y0; y < y1; y++)
+    {
+        for (int w = x0; w < x1; w++)
+        {
+            size_t at = y * wordsPerRow + w;
+            uint64_t v = 0;
+            for (int i = 0; i < layerCount; i++)
+            {
+                const Layer &l = layers[i];
+                if (!l.visible)
+                    continue;
+                if (l.op == OP_OR)
+                    v |= l.bits[at];
+                else if (l.op == OP_XOR)
+                    v ^= l.bits[at];
+                else
+                    v = (v & ~l.mask[at]) | (l.bits[at] & l.mask[at]);
+            }
+
+            uint64_t diff = fullRedraw ? ~(uint64_t)0 : v ^ frame[at];
+            frame[at] = v;
+            // One device row per changed byte; bytes past the panel are skipped
+            for (int b = 0; b < 8 && w * 64 + b * 8 < width; b++)
+            {
+                if ((diff >> (8 * b)) & 0xFF)
+                {
+                    panel.drawDeviceRow((w * 64 + b * 8) / 8, y, v >> (8 * b));
+                    sent++;
+                }
+            }
+        }
+    }
+    panel.endFrame();
+    fullRedraw = false;
+    rowsSent += sent;
+    return sent;
+}
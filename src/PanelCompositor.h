@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include "LedPanel.h"
+#include "LifeArena.h"
+
+// Stacks a few full-panel layers (the Life board, the text ticker, effects)
+// into one framebuffer. Each layer is a bitmap of packed rows, the same
+// layout as GameOfLife::getRow(), with a rectangle marking what changed
+// since the last compose(). Only that area is blended, and only the device
+// rows (8 pixels of one panel row) whose value changed are sent.
+class PanelCompositor
+{
+public:
+    enum BlendOp
+    {
+        OP_OR,  // Lit where either is lit
+        OP_XOR, // Inverts what is below where the layer is lit
+        OP_MASK // Replaces what is below where the layer's mask is set
+    };
+    static const int MAX_LAYERS = 4;
+
+    // Layers start empty, visible and OR'ed, bottom layer first
+    PanelCompositor(LedPanel &panel, int layers);
+
+    // Arena space (LIFE_STATIC_MEMORY) for a w x h panel
+    static constexpr size_t arenaBytes(int w, int h, int layers)
+    {
+        return (2 * layers + 1) * LifeArena::blockBytes((size_t)(w + 63) / 64 * h * 8);
+    }
+
+    int getWordsPerRow() const { return wordsPerRow; }
+
+    // Direct access; mark what you change with markDirty()
+    uint64_t *getRow(int layer, int y) { return &layers[layer].bits[y * wordsPerRow]; }
+    uint64_t *getMaskRow(int layer, int y) { return &layers[layer].mask[y * wordsPerRow]; }
+    void markDirty(int layer, int x0, int y0, int x1, int y1); // Inclusive
+    // Replace a row, marking only the words that differ; returns the pixels changed
+    int setRow(int layer, int y, const uint64_t *words);
+    bool setPixel(int layer, int x, int y, bool on); // True if it changed
+    void clearLayer(int layer);
+    void fillLayer(int layer);
+
+    void setOp(int layer, BlendOp op);
+    void setVisible(int layer, bool visible);
+    bool isVisible(int layer) const { return layers[layer].visible; }
+
+    // Something else drew on the panel: the next compose() sends every row
+    void invalidate() { fullRedraw = true; }
+    // Blend and send what changed; returns the device rows sent
+    int compose();
+    uint32_t getRowsSent() const { return rowsSent; }
+    // What the panel shows, as of the last compose()
+    const uint64_t *getFrame() const { return frame.data(); }
+
+private:
+    struct Layer
+    {
+        LifeVector<uint64_t> bits;
+        LifeVector<uint64_t> mask;
+        BlendOp op;
+        bool visible;
+        // Dirty area, x in words and y in rows, end exclusive; empty when x0 >= x1
+        int x0, y0, x1, y1;
+    };
+
+    LedPanel &panel;
+    int width;
+    int height;
+    int wordsPerRow;
+    int layerCount;
+    Layer layers[MAX_LAYERS];
+    LifeVector<uint64_t> frame; // What the panel shows
+    bool fullRedraw;
+    uint32_t rowsSent;
+
+    void markWords(int layer, int w0, int y0, int w1, int y1);
+};
@@ -0,0 +1,164 @@
+#include "SocketServer.h"
+#include <errno.h>
+#include <string.h>
+
+#ifdef ESP32
+#include <lwip/sockets.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+static const int SEND_TIMEOUT_MS = 1000;
+
+bool SocketServer::begin()
+{
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0)
+        return false;
+
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener, 1) < 0)
+    {
+        close(listener);
+        listener = -1;
+        return false;
+    }
+    // accept() is polled from loop()
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+}
+
+SocketClient SocketServer::accept()
+{
+    SocketClient client;
+    if (listener < 0)
+        return client;
+
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int s = ::accept(listener, (struct sockaddr *)&addr, &len);
+    if (s < 0)
+        return client;
+
+    // Reads never block (MSG_DONTWAIT); writes give up on a stalled peer
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) & ~O_NONBLOCK);
+    struct timeval tv;
+    tv.tv_sec = SEND_TIMEOUT_MS / 1000;
+    tv.tv_usec = (SEND_TIMEOUT_MS % 1000) * 1000;
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    client.sock = s;
+    memcpy(client.peer, &addr.sin_addr.s_addr, 4);
+    return client;
+}
+
+SocketClient &SocketClient::operator=(SocketClient &&other)
+{
+    if (this != &other)
+    {
+        stop();
+        take(other);
+    }
+    return *this;
+}
+
+// Moves other's socket and buffered input here, leaving it unconnected
+void SocketClient::take(SocketClient &other)
+{
+    sock = other.sock;
+    closed = other.closed;
+    memcpy(rx, other.rx, sizeof(rx));
+    head = other.head;
+    tail = other.tail;
+    memcpy(peer, other.peer, sizeof(peer));
+    other.sock = -1;
+    other.closed = false;
+    other.head = other.tail = 0;
+}
+
+void SocketClient::fill()
+{
+    if (sock < 0 || closed || tail == (int)sizeof(rx))
+        return;
+    if (head == tail)
+        head = tail = 0;
+    int n = recv(sock, rx + tail, sizeof(rx) - tail, MSG_DONTWAIT);
+    if (n > 0)
+        tail += n;
+    else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        closed = true;
+}
+
+bool SocketClient::connected()
+{
+    fill();
+    return sock >= 0 && (!closed || head < tail);
+}
+
+int SocketClient::available()
+{
+    fill();
+    return tail - head;
+}
+
+int SocketClient::read()
+{
+    if (available() == 0)
+        return -1;
+    return rx[head++];
+}
+
+void SocketClient::flush()
+{
+    do
+        head = tail = 0;
+    while (available() > 0);
+}
+
+void SocketClient::stop()
+{
+    if (sock >= 0)
+        close(sock);
+    sock = -1;
+    closed = false;
+    head = tail = 0;
+}
+
+size_t SocketClient::print(const char *s)
+{
+    return write((const uint8_t *)s, strlen(s));
+}
+
+size_t SocketClient::write(const uint8_t *data, size_t len)
+{
+    size_t sent = 0;
+    while (sock >= 0 && sent < len)
+    {
+        int n = send(sock, data + sent, len - sent, 0);
+        if (n <= 0)
+            break;
+        sent += n;
+    }
+    return sent;
+}
+
+int SocketClient::writeSome(const uint8_t *data, size_t len)
+{
+    if (sock < 0)
+        return -1;
+    int n = send(sock, data, len, MSG_DONTWAIT);
+    if (n < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    return n;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Just enough of WiFiServer/WiFiClient for the message page, straight on
+// lwIP sockets. Nothing is allocated: the receive buffer lives in the
+// client. A client owns its socket: it cannot be copied, and one that is
+// moved over or destroyed closes the socket it held, as lwIP has only a
+// handful. Unlike WiFiClient it can also send without waiting (writeSome()).
+class SocketClient
+{
+public:
+    SocketClient() {}
+    ~SocketClient() { stop(); }
+    SocketClient(const SocketClient &) = delete;
+    SocketClient &operator=(const SocketClient &) = delete;
+    SocketClient(SocketClient &&other) { take(other); }
+    SocketClient &operator=(SocketClient &&other);
+
+    explicit operator bool() const { return sock >= 0; }
+    bool connected();
+    int available();
+    int read();              // -1 when nothing is buffered
+    void flush();            // Discard unread input, as WiFiClient does
+    void stop();
+    size_t print(const char *s);
+    size_t write(const uint8_t *data, size_t len);
+    // Whatever the socket takes without waiting; -1 once the connection failed
+    int writeSome(const uint8_t *data, size_t len);
+    const uint8_t *remoteIP() const { return peer; }
+    int fd() const { return sock; }
+
+private:
+    friend class SocketServer;
+
+    int sock = -1;
+    bool closed = false; // Peer has shut its side
+    uint8_t rx[128];
+    int head = 0;
+    int tail = 0;
+    uint8_t peer[4] = {0, 0, 0, 0};
+
+    void fill();
+    void take(SocketClient &other);
+};
+
+class SocketServer
+{
+public:
+    SocketServer(uint16_t port) : port(port) {}
+
+    bool begin();
+    // An unconnected client when nobody is waiting
+    SocketClient accept();
+    int fd() const { return listener; }
+
+private:
+    uint16_t port;
+    int listener = -1;
+};
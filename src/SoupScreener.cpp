@@ -0,0 +1,288 @@
+#include "SoupScreener.h"
+#include <stdlib.h>
+#include "LifeTrace.h"
+
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_random.h>
+#include <esp_timer.h>
+
+#if LIFE_STATIC_MEMORY
+// One worker, with its stack and task control block outside the heap
+static const uint32_t WORKER_STACK_BYTES = 8192;
+static StackType_t workerStack[WORKER_STACK_BYTES];
+static StaticTask_t workerTask;
+#endif
+#else
+#include <chrono>
+#include <random>
+#include <thread>
+#endif
+
+SoupScreener::SoupScreener(int w, int h, bool wrap, unsigned int maxGen,
+                           unsigned int minLife)
+    : width(w), height(h), wrapAround(wrap), maxGenerations(maxGen),
+      minLifespan(minLife), running(false), active(0), screened(0), busyMs(0)
+{
+}
+
+SoupScreener::~SoupScreener()
+{
+    end();
+}
+
+void SoupScreener::begin(int count)
+{
+    if (running)
+        return;
+    running = true;
+#if LIFE_STATIC_MEMORY && defined(ESP32)
+    count = 1;
+#endif
+    for (int i = 0; i < count; i++)
+    {
+        active++;
+#ifdef ESP32
+        // Low priority on the core the Arduino loop does not use
+#if LIFE_STATIC_MEMORY
+        xTaskCreateStaticPinnedToCore(workerEntry, "soup", WORKER_STACK_BYTES, this, 1,
+                                      workerStack, &workerTask, 0);
+#else
+        xTaskCreatePinnedToCore(workerEntry, "soup", 8192, this, 1, nullptr, 0);
+#endif
+#else
+        workers.push_back(new std::thread(workerEntry, this));
+#endif
+    }
+}
+
+void SoupScreener::end()
+{
+    {
+        // Under the lock, so a worker cannot miss it between its check and its wait
+        std::lock_guard<std::mutex> guard(queueLock);
+        running = false;
+    }
+    queueRoom.notify_all();
+#ifdef ESP32
+    while (active > 0)
+        sleepMs(10);
+#else
+    for (void *w : workers)
+    {
+        std::thread *t = static_cast<std::thread *>(w);
+        t->join();
+        delete t;
+    }
+    workers.clear();
+#endif
+}
+
+bool SoupScreener::takeSeed(SoupResult &out)
+{
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        if (readySize == 0)
+            return false;
+
+        // Queue is kept sorted best first
+        out = ready[0];
+        for (int i = 1; i < readySize; i++)
+            ready[i - 1] = ready[i];
+        readySize--;
+    }
+    queueRoom.notify_one();
+    return true;
+}
+
+int SoupScreener::readyCount()
+{
+    std::lock_guard<std::mutex> guard(queueLock);
+    return readySize;
+}
+
+// Blocks, without waking, while the queue is full
+void SoupScreener::waitForRoom()
+{
+    std::unique_lock<std::mutex> lock(queueLock);
+    queueRoom.wait(lock, [this]() { return readySize < READY_QUEUE_SIZE || !running; });
+}
+
+void SoupScreener::offer(const SoupResult &r)
+{
+    std::lock_guard<std::mutex> guard(queueLock);
+    if (readySize == READY_QUEUE_SIZE)
+    {
+        if (r.score <= ready[readySize - 1].score)
+            return;
+        readySize--; // Drop the worst
+    }
+
+    int i = readySize++;
+    while (i > 0 && ready[i - 1].score < r.score)
+    {
+        ready[i] = ready[i - 1];
+        i--;
+    }
+    ready[i] = r;
+}
+
+SoupResult SoupScreener::evaluate(GameOfLife &game, uint32_t seed)
+{
+    game.clear();
+    game.clearHistory();
+    game.resetGenerations();
+    game.randomize(seed);
+
+    SoupResult r = {};
+    r.seed = seed;
+    int population = game.getPopulation();
+    r.peakPopulation = population;
+
+    // Same finish decisions as the display loop, without any rendering
+    while (!game.isGameFinished())
+    {
+        game.computeNextGeneration();
+        int next = game.getPopulation();
+        r.populationSwing += abs(next - population);
+        if (next > r.peakPopulation)
+            r.peakPopulation = next;
+        population = next;
+    }
+
+    r.lifespan = game.getGenerationCount();
+    r.finalPeriod = game.getFinalPeriod();
+    r.finalPopulation = population;
+    r.score = score(r, game.getMaxGenerations());
+    return r;
+}
+
+void SoupScreener::evaluateBatch(SoupBatch &batch, const uint32_t *seeds, SoupResult *out)
+{
+    TRACE_SCOPE(TRACE_SCREEN_BATCH, seeds[0]);
+    const int lanes = SoupBatch::LANES;
+    int population[lanes];
+    int next[lanes];
+
+    for (int l = 0; l < lanes; l++)
+        batch.randomize(l, seeds[l]);
+    batch.getPopulations(population);
+    for (int l = 0; l < lanes; l++)
+    {
+        out[l] = SoupResult();
+        out[l].seed = seeds[l];
+        out[l].peakPopulation = population[l];
+    }
+
+    // Finished lanes keep their board, so their population change is zero
+    bool running;
+    do
+    {
+        running = batch.advance() != 0;
+        batch.getPopulations(next);
+        for (int l = 0; l < lanes; l++)
+        {
+            out[l].populationSwing += abs(next[l] - population[l]);
+            if (next[l] > out[l].peakPopulation)
+                out[l].peakPopulation = next[l];
+            population[l] = next[l];
+        }
+    } while (running);
+
+    for (int l = 0; l < lanes; l++)
+    {
+        out[l].lifespan = batch.getGenerationCount(l);
+        out[l].finalPeriod = batch.getFinalPeriod(l);
+        out[l].finalPopulation = population[l];
+        out[l].score = score(out[l], batch.getMaxGenerations());
+    }
+}
+
+uint32_t SoupScreener::score(const SoupResult &r, unsigned int maxGen)
+{
+    // Lifespan dominates; churn and a visible oscillator at the end break ties
+    uint32_t s = r.lifespan * 16;
+    s += r.populationSwing < 255 ? r.populationSwing : 255;
+    if (r.finalPeriod == 0 && r.lifespan >= maxGen)
+        s += 64; // Still going when the display would have cut it off
+    else if (r.finalPeriod > 1 && r.finalPopulation > 0)
+        s += (r.finalPeriod < 15 ? r.finalPeriod : 15) * 8;
+    return s;
+}
+
+void SoupScreener::workerEntry(void *arg)
+{
+    SoupScreener *self = static_cast<SoupScreener *>(arg);
+    self->workerLoop();
+    self->active--;
+#ifdef ESP32
+    vTaskDelete(nullptr);
+#endif
+}
+
+void SoupScreener::workerLoop()
+{
+    SoupBatch batch(width, height, wrapAround, maxGenerations);
+    uint32_t seeds[SoupBatch::LANES];
+    SoupResult results[SoupBatch::LANES];
+    uint32_t x = entropy();
+
+    while (running)
+    {
+        uint32_t start = nowMs();
+        for (int l = 0; l < SoupBatch::LANES; l++)
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            seeds[l] = x;
+        }
+
+        evaluateBatch(batch, seeds, results);
+        screened += SoupBatch::LANES;
+        for (int l = 0; l < SoupBatch::LANES; l++)
+        {
+            if (results[l].lifespan >= minLifespan)
+                offer(results[l]);
+        }
+
+        busyMs += nowMs() - start;
+
+        // A full queue holds the best seeds found so far; better ones can
+        // wait for room rather than keep the core awake. The short delay
+        // lets the idle task feed the watchdog.
+        waitForRoom();
+        sleepMs(1);
+    }
+}
+
+uint32_t SoupScreener::entropy()
+{
+#ifdef ESP32
+    return esp_random();
+#else
+    std::random_device rd;
+    return rd();
+#endif
+}
+
+uint32_t SoupScreener::nowMs()
+{
+#ifdef ESP32
+    return (uint32_t)(esp_timer_get_time() / 1000);
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+void SoupScreener::sleepMs(uint32_t ms)
+{
+#ifdef ESP32
+    vTaskDelay(pdMS_TO_TICKS(ms));
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#endif
+}
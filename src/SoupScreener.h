@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "life.h"
+#include "LifeBatch.h"
+
+// Runs random soups headless in the background and keeps the best few
+// seeds ready for the foreground to display. Once the ready queue is full
+// the workers block until a seed is taken, so the core can sleep.
+// On the ESP32 the workers are FreeRTOS tasks pinned to core 0 (the Arduino
+// loop runs on core 1); on a host they are std::threads.
+struct SoupResult
+{
+    uint32_t seed;
+    unsigned int lifespan;    // Generations until isGameFinished()
+    unsigned int finalPeriod; // 0 = hit the generation limit, 1 = static
+    int peakPopulation;
+    int finalPopulation;
+    int populationSwing;      // Sum of |population change| per generation
+    uint32_t score;
+};
+
+// Screening runs a full machine word of soups per batch
+#ifdef ESP32
+typedef LifeBatch<uint32_t> SoupBatch;
+#else
+typedef LifeBatch<uint64_t> SoupBatch;
+#endif
+
+class SoupScreener
+{
+public:
+    static const int READY_QUEUE_SIZE = 4;
+
+    SoupScreener(int w, int h, bool wrap = true, unsigned int maxGen = 180,
+                 unsigned int minLifespan = 30);
+    ~SoupScreener();
+
+    void begin(int workers = 1);
+    void end();
+
+    // Pop the best seed from the ready queue; false if it is empty
+    bool takeSeed(SoupResult &out);
+    int readyCount();
+    uint32_t getScreenedCount() const { return screened; }
+    // Time the workers have spent screening, all of them together
+    uint32_t getBusyMs() const { return busyMs; }
+
+    // Run one soup to completion and score it
+    static SoupResult evaluate(GameOfLife &game, uint32_t seed);
+    // Same scoring for SoupBatch::LANES soups at once
+    static void evaluateBatch(SoupBatch &batch, const uint32_t *seeds, SoupResult *out);
+    static uint32_t score(const SoupResult &r, unsigned int maxGen);
+
+private:
+    int width;
+    int height;
+    bool wrapAround;
+    unsigned int maxGenerations;
+    unsigned int minLifespan;
+
+    std::mutex queueLock;
+    std::condition_variable queueRoom; // A seed was taken, or end()
+    SoupResult ready[READY_QUEUE_SIZE];
+    int readySize = 0;
+
+    std::atomic<bool> running;
+    std::atomic<int> active;
+    std::atomic<uint32_t> screened;
+    std::atomic<uint32_t> busyMs;
+    std::vector<void *> workers; // std::thread* on host, unused on device
+
+    void offer(const SoupResult &r);
+    void waitForRoom();
+    void workerLoop();
+    static void workerEntry(void *arg);
+    static uint32_t entropy();
+    static void sleepMs(uint32_t ms);
+    static uint32_t nowMs();
+};
@@ -0,0 +1,398 @@
+#include "SparseLife.h"
+#include "LifePatterns.h"
+#include <algorithm>
+
+// Floor division for tile coordinates (relies on arithmetic right shift)
+static inline int32_t tileOf(int32_t v) { return v >> 3; }
+
+static inline uint8_t tileRow(uint64_t tile, int row)
+{
+    return (uint8_t)(tile >> (row * 8));
+}
+
+static inline int32_t floorDiv(int64_t sum, int64_t n)
+{
+    return (int32_t)(sum >= 0 ? sum / n : -((-sum + n - 1) / n));
+}
+
+SparseLife::SparseLife(unsigned int maxGen, size_t maxTileCount)
+    : maxGenerations(maxGen), maxTiles(maxTileCount)
+{
+}
+
+void SparseLife::clear()
+{
+    tiles.clear();
+    pendingValid = false;
+}
+
+uint64_t SparseLife::getTile(int32_t tx, int32_t ty) const
+{
+    TileMap::const_iterator it = tiles.find(tileKey(tx, ty));
+    return it == tiles.end() ? 0 : it->second;
+}
+
+bool SparseLife::getCell(int32_t x, int32_t y) const
+{
+    uint64_t tile = getTile(tileOf(x), tileOf(y));
+    return (tile >> ((y & 7) * 8 + (x & 7))) & 1;
+}
+
+void SparseLife::setCell(int32_t x, int32_t y, bool state)
+{
+    uint64_t key = tileKey(tileOf(x), tileOf(y));
+    uint64_t bit = (uint64_t)1 << ((y & 7) * 8 + (x & 7));
+    TileMap::iterator it = tiles.find(key);
+
+    if (state)
+    {
+        if (it == tiles.end())
+            tiles[key] = bit;
+        else
+            it->second |= bit;
+    }
+    else if (it != tiles.end())
+    {
+        it->second &= ~bit;
+        if (it->second == 0)
+            tiles.erase(it);
+    }
+    pendingValid = false;
+}
+
+void SparseLife::loadBoard(const GameOfLife &game, int32_t x, int32_t y)
+{
+    for (int j = 0; j < game.getHeight(); j++)
+    {
+        for (int i = 0; i < game.getWidth(); i++)
+        {
+            if (game.getCell(i, j))
+                setCell(x + i, y + j, true);
+        }
+    }
+}
+
+uint64_t SparseLife::nextTile(int32_t tx, int32_t ty) const
+{
+    uint64_t around[3][3];
+    for (int dy = -1; dy <= 1; dy++)
+        for (int dx = -1; dx <= 1; dx++)
+            around[dy + 1][dx + 1] = getTile(tx + dx, ty + dy);
+
+    // Ten 10-bit rows: the tile plus a one cell border from its neighbours
+    uint16_t rows[10];
+    for (int r = 0; r < 10; r++)
+    {
+        int ty3 = r == 0 ? 0 : (r == 9 ? 2 : 1);
+        int row = r == 0 ? 7 : (r == 9 ? 0 : r - 1);
+        uint16_t left = tileRow(around[ty3][0], row) >> 7;
+        uint16_t centre = tileRow(around[ty3][1], row);
+        uint16_t right = tileRow(around[ty3][2], row) & 1;
+        rows[r] = left | (centre << 1) | (right << 9);
+    }
+
+    uint64_t result = 0;
+    for (int y = 0; y < 8; y++)
+    {
+        uint16_t a = rows[y], b = rows[y + 1], c = rows[y + 2];
+        uint16_t in[8] = {(uint16_t)(a << 1), a, (uint16_t)(a >> 1),
+                          (uint16_t)(b << 1), (uint16_t)(b >> 1),
+                          (uint16_t)(c << 1), c, (uint16_t)(c >> 1)};
+
+        // Counter bits: s2 saturates once four or more neighbours are seen
+        uint16_t s0 = 0, s1 = 0, s2 = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            uint16_t c0 = s0 & in[i];
+            s0 ^= in[i];
+            uint16_t c1 = s1 & c0;
+            s1 ^= c0;
+            s2 |= c1;
+        }
+        uint16_t next = ~s2 & s1 & (s0 | b);
+        result |= (uint64_t)((next >> 1) & 0xFF) << (y * 8);
+    }
+    return result;
+}
+
+void SparseLife::computePending()
+{
+    // Only live tiles and their neighbours can hold live cells next time
+    std::vector<uint64_t> candidates;
+    candidates.reserve(tiles.size() * 9);
+    for (TileMap::const_iterator it = tiles.begin(); it != tiles.end(); ++it)
+    {
+        int32_t tx = keyX(it->first), ty = keyY(it->first);
+        for (int dy = -1; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++)
+                candidates.push_back(tileKey(tx + dx, ty + dy));
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    pending.clear();
+    pendingChanged = false;
+    for (uint64_t key : candidates)
+    {
+        uint64_t tile = nextTile(keyX(key), keyY(key));
+        if (tile)
+            pending[key] = tile;
+        if (tile != getTile(keyX(key), keyY(key)))
+            pendingChanged = true;
+    }
+    pendingValid = true;
+}
+
+void SparseLife::computeNextGeneration()
+{
+    if (!pendingValid)
+        computePending();
+    tiles.swap(pending);
+    pendingValid = false;
+    generationCount++;
+}
+
+bool SparseLife::isGameFinished()
+{
+    if (generationCount >= maxGenerations)
+    {
+        finalPeriod = 0;
+        return true;
+    }
+
+    // Out of tile budget: treat like the generation limit
+    if (tiles.size() > maxTiles)
+    {
+        finalPeriod = 0;
+        clearHistory();
+        return true;
+    }
+
+    // The next generation is kept for computeNextGeneration(), and reused
+    // when an earlier call already worked it out
+    if (!pendingValid)
+        computePending();
+    if (!pendingChanged)
+    {
+        finalPeriod = 1;
+        clearHistory();
+        return true;
+    }
+
+    unsigned long currentHash = calculateBoardHash();
+    for (size_t i = 0; i < boardHistory.size(); i++)
+    {
+        if (boardHistory[i] == currentHash)
+        {
+            finalPeriod = boardHistory.size() - i;
+            clearHistory();
+            return true;
+        }
+    }
+
+    boardHistory.push_back(currentHash);
+    if (boardHistory.size() > GameOfLife::HISTORY_SIZE)
+    {
+        boardHistory.erase(boardHistory.begin());
+    }
+    return false;
+}
+
+unsigned long SparseLife::calculateBoardHash() const
+{
+    // Tile order in the map is arbitrary, so combine per-tile hashes with a sum
+    uint64_t hash = 5381;
+    for (TileMap::const_iterator it = tiles.begin(); it != tiles.end(); ++it)
+    {
+        uint64_t z = (it->first * 0x9E3779B97F4A7C15ull) ^ it->second;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        hash += z ^ (z >> 31);
+    }
+    return (unsigned long)(hash ^ (hash >> 32));
+}
+
+int SparseLife::getPopulation() const
+{
+    int count = 0;
+    for (TileMap::const_iterator it = tiles.begin(); it != tiles.end(); ++it)
+        count += __builtin_popcountll(it->second);
+    return count;
+}
+
+bool SparseLife::getBoundingBox(int32_t &minX, int32_t &minY, int32_t &maxX, int32_t &maxY) const
+{
+    bool found = false;
+    for (TileMap::const_iterator it = tiles.begin(); it != tiles.end(); ++it)
+    {
+        int32_t x0 = keyX(it->first) * 8, y0 = keyY(it->first) * 8;
+        uint8_t columns = 0;
+        int top = 8, bottom = -1;
+        for (int r = 0; r < 8; r++)
+        {
+            uint8_t row = tileRow(it->second, r);
+            if (row)
+            {
+                columns |= row;
+                if (top == 8)
+                    top = r;
+                bottom = r;
+            }
+        }
+        int leftmost = __builtin_ctz(columns);
+        int rightmost = 31 - __builtin_clz(columns);
+
+        if (!found || x0 + leftmost < minX)
+            minX = x0 + leftmost;
+        if (!found || x0 + rightmost > maxX)
+            maxX = x0 + rightmost;
+        if (!found || y0 + top < minY)
+            minY = y0 + top;
+        if (!found || y0 + bottom > maxY)
+            maxY = y0 + bottom;
+        found = true;
+    }
+    return found;
+}
+
+bool SparseLife::getCentroid(int32_t &cx, int32_t &cy) const
+{
+    int64_t sumX = 0, sumY = 0, count = 0;
+    for (TileMap::const_iterator it = tiles.begin(); it != tiles.end(); ++it)
+    {
+        int64_t x0 = keyX(it->first) * 8, y0 = keyY(it->first) * 8;
+        uint64_t bits = it->second;
+        while (bits)
+        {
+            int b = __builtin_ctzll(bits);
+            sumX += x0 + (b & 7);
+            sumY += y0 + (b >> 3);
+            count++;
+            bits &= bits - 1;
+        }
+    }
+    if (count == 0)
+        return false;
+    cx = floorDiv(sumX, count);
+    cy = floorDiv(sumY, count);
+    return true;
+}
+
+bool SparseLife::findObject(int32_t x, int32_t y, int radius, int32_t &cx, int32_t &cy) const
+{
+    // Nearest live cell, searching outwards ring by ring
+    bool found = false;
+    int32_t sx = 0, sy = 0;
+    for (int d = 0; d <= radius && !found; d++)
+    {
+        for (int dy = -d; dy <= d && !found; dy++)
+        {
+            for (int dx = -d; dx <= d; dx++)
+            {
+                if ((dx != -d && dx != d && dy != -d && dy != d) || !getCell(x + dx, y + dy))
+                    continue;
+                sx = x + dx;
+                sy = y + dy;
+                found = true;
+                break;
+            }
+        }
+    }
+    if (!found)
+        return false;
+
+    // Grow the cluster; cells up to two apart belong together so that
+    // spaceships stay one object through all their phases
+    const size_t MAX_OBJECT_CELLS = 64;
+    std::vector<int32_t> cellsX(1, sx), cellsY(1, sy);
+    for (size_t i = 0; i < cellsX.size() && cellsX.size() < MAX_OBJECT_CELLS; i++)
+    {
+        for (int dy = -2; dy <= 2; dy++)
+        {
+            for (int dx = -2; dx <= 2; dx++)
+            {
+                int32_t nx = cellsX[i] + dx, ny = cellsY[i] + dy;
+                if (!getCell(nx, ny))
+                    continue;
+                bool seen = false;
+                for (size_t j = 0; j < cellsX.size() && !seen; j++)
+                    seen = cellsX[j] == nx && cellsY[j] == ny;
+                if (!seen && cellsX.size() < MAX_OBJECT_CELLS)
+                {
+                    cellsX.push_back(nx);
+                    cellsY.push_back(ny);
+                }
+            }
+        }
+    }
+
+    int64_t sumX = 0, sumY = 0;
+    for (size_t i = 0; i < cellsX.size(); i++)
+    {
+        sumX += cellsX[i];
+        sumY += cellsY[i];
+    }
+    cx = floorDiv(sumX, cellsX.size());
+    cy = floorDiv(sumY, cellsX.size());
+    return true;
+}
+
+void SparseLife::createGlider(int startX, int startY)
+{
+    stampGlider(*this, startX, startY);
+}
+
+void SparseLife::createBlinker(int startX, int startY)
+{
+    stampBlinker(*this, startX, startY);
+}
+
+void SparseLife::createPulsar(int startX, int startY)
+{
+    stampPulsar(*this, startX, startY);
+}
+
+void SparseLife::createGliderGun(int startX, int startY)
+{
+    stampGliderGun(*this, startX, startY);
+}
+
+void LifeViewport::centreOn(int32_t x, int32_t y)
+{
+    originX = x - width / 2;
+    originY = y - height / 2;
+}
+
+void LifeViewport::followObject(int32_t x, int32_t y)
+{
+    mode = FOLLOW_OBJECT;
+    objectX = x;
+    objectY = y;
+    centreOn(x, y);
+}
+
+void LifeViewport::update(const SparseLife &plane, int maxStep)
+{
+    int32_t cx, cy;
+    switch (mode)
+    {
+    case FOLLOW_CENTROID:
+        if (!plane.getCentroid(cx, cy))
+            return;
+        break;
+    case FOLLOW_OBJECT:
+        // Objects move at most one cell per generation
+        if (!plane.findObject(objectX, objectY, 4, cx, cy))
+            return;
+        objectX = cx;
+        objectY = cy;
+        break;
+    default:
+        return;
+    }
+
+    int32_t dx = (cx - width / 2) - originX;
+    int32_t dy = (cy - height / 2) - originY;
+    originX += std::max(-maxStep, std::min(maxStep, (int)dx));
+    originY += std::max(-maxStep, std::min(maxStep, (int)dy));
+}
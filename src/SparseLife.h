@@ -0,0 +1,106 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "life.h"
+
+// Game of Life on an unbounded plane.
+// Live cells are kept in 8x8 tiles (one MAX7219 module's worth, packed into
+// a uint64_t) in a hash map. Only tiles holding live cells are stored, so
+// memory follows the live area rather than how far patterns have travelled.
+class SparseLife
+{
+public:
+    SparseLife(unsigned int maxGen = 180, size_t maxTiles = 512);
+
+    void clear();
+    bool getCell(int32_t x, int32_t y) const;
+    void setCell(int32_t x, int32_t y, bool state);
+
+    // Copy a bounded board onto the plane with its top left at (x, y)
+    void loadBoard(const GameOfLife &game, int32_t x, int32_t y);
+
+    void computeNextGeneration();
+    bool isGameFinished();
+    void resetGenerations() { generationCount = 0; }
+    unsigned int getGenerationCount() const { return generationCount; }
+    unsigned int getFinalPeriod() const { return finalPeriod; }
+    void clearHistory() { boardHistory.clear(); }
+    unsigned long calculateBoardHash() const;
+
+    int getPopulation() const;
+    size_t getTileCount() const { return tiles.size(); }
+    bool getBoundingBox(int32_t &minX, int32_t &minY, int32_t &maxX, int32_t &maxY) const;
+    bool getCentroid(int32_t &cx, int32_t &cy) const;
+    // Centroid of the cluster of live cells nearest (x, y), within radius
+    bool findObject(int32_t x, int32_t y, int radius, int32_t &cx, int32_t &cy) const;
+
+    void createGlider(int startX, int startY);
+    void createBlinker(int startX, int startY);
+    void createGliderGun(int startX, int startY);
+    void createPulsar(int startX, int startY);
+
+private:
+    typedef std::unordered_map<uint64_t, uint64_t> TileMap;
+
+    TileMap tiles;
+    TileMap pending;         // Next generation, computed early by isGameFinished()
+    bool pendingValid = false;
+    bool pendingChanged = false;
+    std::vector<unsigned long> boardHistory;
+    unsigned int generationCount = 0;
+    unsigned int maxGenerations;
+    unsigned int finalPeriod = 0;
+    size_t maxTiles;
+
+    static uint64_t tileKey(int32_t tx, int32_t ty)
+    {
+        return ((uint64_t)(uint32_t)tx << 32) | (uint32_t)ty;
+    }
+    static int32_t keyX(uint64_t key) { return (int32_t)(key >> 32); }
+    static int32_t keyY(uint64_t key) { return (int32_t)(uint32_t)key; }
+
+    uint64_t getTile(int32_t tx, int32_t ty) const;
+    uint64_t nextTile(int32_t tx, int32_t ty) const;
+    void computePending();
+};
+
+// Which part of the plane ends up on the panel
+class LifeViewport
+{
+public:
+    enum Mode
+    {
+        FIXED,
+        FOLLOW_CENTROID, // Centre of mass of everything alive
+        FOLLOW_OBJECT    // One cluster, e.g. a glider, tracked generation to generation
+    };
+
+    LifeViewport(int w, int h) : width(w), height(h) {}
+
+    void setMode(Mode m) { mode = m; }
+    Mode getMode() const { return mode; }
+    void centreOn(int32_t x, int32_t y);
+    void followObject(int32_t x, int32_t y);
+
+    // Move towards the target, at most maxStep cells per call so the
+    // picture pans rather than jumps
+    void update(const SparseLife &plane, int maxStep = 1);
+
+    int32_t left() const { return originX; }
+    int32_t top() const { return originY; }
+    bool getCell(const SparseLife &plane, int x, int y) const
+    {
+        return plane.getCell(originX + x, originY + y);
+    }
+
+private:
+    int width;
+    int height;
+    Mode mode = FOLLOW_CENTROID;
+    int32_t originX = 0;
+    int32_t originY = 0;
+    int32_t objectX = 0; // Last known centre of the followed object
+    int32_t objectY = 0;
+};
@@ -0,0 +1,110 @@
+// Generated by tools/webassets.py from web/; do not edit
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+struct WebAsset
+{
+    const char *path;
+    const char *type;
+    const char *etag; // Quoted, as sent
+    const uint8_t *data; // Gzipped
+    size_t size;
+};
+
+// index.html, 702 bytes, 448 gzipped
+static const uint8_t asset_index_html[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x4d, 0x52, 0x51, 0x6b, 0xdc, 0x30,
+    0x0c, 0x7e, 0xcf, 0xaf, 0xd0, 0xfc, 0x50, 0x92, 0xb5, 0x24, 0x5b, 0xa1, 0x14, 0x56, 0x27, 0xb0,
+    0xed, 0x8e, 0x6e, 0xd0, 0xb0, 0xd2, 0x1e, 0xac, 0x7b, 0x2a, 0x8e, 0xa3, 0x4b, 0xdc, 0x39, 0x4e,
+    0x16, 0x2b, 0xd7, 0x1c, 0x63, 0xff, 0x7d, 0x76, 0x7c, 0x3d, 0x2e, 0x60, 0x64, 0x4b, 0x9f, 0xa4,
+    0x4f, 0x5f, 0xc4, 0xdf, 0xad, 0x7e, 0x7c, 0xdd, 0xfc, 0xba, 0x5f, 0x43, 0x4b, 0x9d, 0x2e, 0x22,
+    0xfe, 0x66, 0x50, 0xd4, 0xce, 0x90, 0x22, 0x8d, 0x45, 0x29, 0x5e, 0x94, 0x5c, 0xa1, 0x55, 0x8d,
+    0xb1, 0xb0, 0x41, 0x4b, 0x70, 0x2f, 0x1a, 0xe4, 0x59, 0x88, 0x46, 0xdc, 0xca, 0x51, 0x0d, 0x04,
+    0x76, 0x94, 0x39, 0xd3, 0x6a, 0x87, 0xe9, 0x8b, 0x65, 0x05, 0xcf, 0x82, 0xfb, 0x18, 0x2f, 0x22,
+    0x4b, 0xe3, 0x9d, 0x32, 0x08, 0x39, 0x30, 0x76, 0x13, 0x45, 0xdb, 0xc9, 0x48, 0x52, 0xbd, 0x81,
+    0x47, 0x34, 0xf5, 0x06, 0x67, 0x8a, 0x93, 0xe8, 0x6f, 0x04, 0x60, 0x7a, 0x29, 0x64, 0xbb, 0xc0,
+    0xb2, 0xb3, 0xc3, 0x23, 0x67, 0x70, 0x0e, 0xa5, 0xa0, 0x36, 0x1d, 0x85, 0xa9, 0xfb, 0x2e, 0x4e,
+    0xe0, 0x3d, 0x7c, 0xfc, 0xb0, 0x7c, 0x37, 0x2e, 0x67, 0x27, 0x46, 0x18, 0xf1, 0xcf, 0xe4, 0xc9,
+    0xe5, 0x60, 0xf0, 0x15, 0x9e, 0xca, 0xbb, 0x6f, 0x44, 0xc3, 0x43, 0x70, 0xc6, 0x89, 0x47, 0x9d,
+    0x10, 0x38, 0x2b, 0x1f, 0x6f, 0x97, 0xa2, 0x75, 0x2f, 0xa7, 0x0e, 0x0d, 0xa5, 0x0d, 0xd2, 0x5a,
+    0xa3, 0xbf, 0x7e, 0xd9, 0x7f, 0xaf, 0x63, 0x46, 0x33, 0x3d, 0x6f, 0xfb, 0xb1, 0x63, 0x49, 0x5a,
+    0xa2, 0xb5, 0x6e, 0xe2, 0x74, 0x27, 0xf4, 0x84, 0xbe, 0xd0, 0xa1, 0x55, 0xda, 0x0f, 0x68, 0x62,
+    0x76, 0xbb, 0xde, 0xb0, 0x8b, 0x63, 0xf1, 0xf3, 0xb7, 0x01, 0x2e, 0x60, 0x2b, 0xb4, 0xc5, 0xe4,
+    0x34, 0xc1, 0xba, 0x51, 0x63, 0x33, 0x69, 0xed, 0xbc, 0xff, 0xa2, 0x13, 0x8d, 0xb2, 0xa0, 0x78,
+    0xc4, 0xab, 0xbe, 0xde, 0x43, 0x6f, 0x74, 0x2f, 0xea, 0x9c, 0xfd, 0x14, 0x24, 0xdb, 0x38, 0x61,
+    0x0e, 0x30, 0x14, 0x5c, 0x0a, 0xb3, 0x13, 0x16, 0x54, 0x1d, 0x64, 0xf6, 0x1a, 0x07, 0x97, 0xbb,
+    0x0c, 0x01, 0x52, 0x15, 0xe5, 0xea, 0xb9, 0xfc, 0xfc, 0x74, 0x7d, 0x39, 0xcf, 0x60, 0x91, 0xa0,
+    0x0b, 0xd4, 0x79, 0x56, 0x05, 0x50, 0xc4, 0xfd, 0x4c, 0x4b, 0x8d, 0xe3, 0x80, 0x60, 0x44, 0xe7,
+    0x14, 0xde, 0x8e, 0x9d, 0xff, 0x0b, 0xbe, 0x99, 0x16, 0x15, 0xea, 0xa2, 0xb4, 0xcd, 0x27, 0xae,
+    0xcc, 0x30, 0x11, 0xd0, 0x7e, 0x70, 0x08, 0xf2, 0xe1, 0x03, 0xfa, 0xa0, 0x09, 0x83, 0x4e, 0xcc,
+    0x1a, 0x4d, 0x43, 0x6d, 0xce, 0x2e, 0xaf, 0xae, 0x3c, 0xa9, 0x90, 0xcd, 0xab, 0x71, 0x39, 0x6e,
+    0x36, 0xdf, 0xc5, 0xd9, 0xe5, 0x71, 0x5a, 0xcf, 0x4e, 0x55, 0xa7, 0x5c, 0xc5, 0x45, 0xd7, 0x9c,
+    0xf9, 0x3d, 0x80, 0x85, 0x82, 0x13, 0x40, 0x6a, 0x25, 0x7f, 0x07, 0x5f, 0xd8, 0x0d, 0xcf, 0x2b,
+    0xf3, 0xea, 0x2c, 0x6a, 0x2d, 0x6b, 0xfa, 0x1f, 0x79, 0xed, 0x69, 0x7e, 0xbe, 0x02, 0x00, 0x00,
+};
+
+// live.js, 1674 bytes, 873 gzipped
+static const uint8_t asset_live_js[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x6d, 0x55, 0x6d, 0x6f, 0x9b, 0x48,
+    0x10, 0xfe, 0xce, 0xaf, 0x18, 0x51, 0xa9, 0x81, 0x9a, 0x60, 0x3b, 0x6d, 0xd3, 0x5c, 0x88, 0x73,
+    0xba, 0xb6, 0x91, 0x1a, 0x5d, 0x4f, 0x3d, 0xb9, 0xb9, 0xf8, 0xa4, 0x28, 0x77, 0x5a, 0x60, 0x30,
+    0xab, 0xc3, 0xbb, 0x08, 0xd6, 0xc1, 0x28, 0xe7, 0xff, 0xde, 0x19, 0x16, 0xb0, 0xdb, 0x3b, 0xc9,
+    0x66, 0xd9, 0x99, 0x67, 0x9e, 0x9d, 0xd7, 0x65, 0x3a, 0x85, 0x8f, 0x95, 0x68, 0x6a, 0x30, 0x39,
+    0x42, 0x29, 0x14, 0x16, 0x90, 0x55, 0x7a, 0x03, 0x9f, 0x65, 0x86, 0xf7, 0x12, 0x1b, 0xac, 0x4e,
+    0x6a, 0x58, 0x61, 0xfc, 0x55, 0x27, 0xff, 0xa0, 0x89, 0xa0, 0x85, 0x05, 0xcc, 0x40, 0x5a, 0x7c,
+    0xac, 0x8d, 0x21, 0x6c, 0xa5, 0x1b, 0xe7, 0x49, 0x54, 0xf0, 0xf9, 0xf6, 0xfe, 0xe6, 0xef, 0xdf,
+    0xbf, 0x2c, 0xef, 0x08, 0x73, 0x31, 0x8f, 0x60, 0x3a, 0x3d, 0x12, 0x49, 0x05, 0x1b, 0x21, 0x55,
+    0x98, 0x94, 0xa5, 0xd3, 0xa1, 0x13, 0x2c, 0x8a, 0x3a, 0x20, 0x0e, 0x51, 0xa5, 0xab, 0x7e, 0xfd,
+    0x14, 0x30, 0xd9, 0xfb, 0xd6, 0x60, 0x1d, 0x39, 0x0e, 0xd9, 0x2f, 0xb7, 0xea, 0xb4, 0x40, 0xb5,
+    0x36, 0x39, 0x24, 0x3a, 0xc5, 0x14, 0x62, 0xd6, 0x11, 0x99, 0xd1, 0x03, 0x41, 0x85, 0x65, 0x21,
+    0x12, 0xa9, 0xd6, 0xec, 0xd2, 0x06, 0x74, 0x05, 0x7f, 0x7e, 0x59, 0x9e, 0x10, 0x54, 0x2a, 0x27,
+    0xdb, 0xaa, 0xc4, 0x48, 0xad, 0x98, 0xa7, 0xf6, 0xe2, 0x00, 0xca, 0x00, 0x76, 0xbe, 0xf3, 0xec,
+    0x00, 0x8c, 0xaa, 0x27, 0xcf, 0x87, 0x67, 0x60, 0x8f, 0x2a, 0x8e, 0x2d, 0x80, 0xda, 0x2e, 0x49,
+    0x04, 0xa9, 0x26, 0x4d, 0x42, 0xdb, 0xf8, 0xa1, 0x9c, 0x4c, 0x1e, 0x23, 0x42, 0xfc, 0xbb, 0x00,
+    0x2f, 0x81, 0x97, 0x30, 0x3f, 0x7b, 0xe7, 0xc3, 0xd5, 0x15, 0xd4, 0x11, 0xe1, 0x27, 0x0b, 0x78,
+    0x17, 0xc1, 0x1e, 0x9a, 0x5c, 0x16, 0x38, 0xe8, 0x2f, 0x7c, 0xc2, 0xa3, 0xd9, 0x56, 0x0a, 0x2a,
+    0x52, 0xf2, 0x91, 0xe4, 0x9b, 0xc7, 0x07, 0x49, 0x3e, 0x21, 0xa2, 0xe5, 0xca, 0x06, 0x11, 0xda,
+    0x10, 0x23, 0x9f, 0x40, 0xec, 0x1b, 0x90, 0x8a, 0x38, 0xc9, 0xb3, 0xa8, 0xdb, 0x8d, 0x86, 0x05,
+    0x58, 0x29, 0xbd, 0x5c, 0x33, 0x43, 0x71, 0x7a, 0x1a, 0x80, 0x9c, 0x4c, 0xfc, 0x0e, 0x06, 0x96,
+    0xed, 0x41, 0x3e, 0x12, 0x6c, 0x07, 0x3f, 0x1f, 0xb6, 0x7f, 0xf5, 0x11, 0xc0, 0xe5, 0x10, 0x0a,
+    0x19, 0xec, 0x9d, 0xbd, 0x73, 0xc8, 0x10, 0x77, 0x81, 0x67, 0x53, 0xd3, 0x55, 0x87, 0x28, 0x52,
+    0x9d, 0x6c, 0x37, 0xa8, 0x4c, 0xb8, 0x46, 0x73, 0x53, 0x20, 0xbf, 0xbe, 0x6f, 0x6f, 0x53, 0xcf,
+    0x2d, 0xe4, 0x13, 0xba, 0x7e, 0x00, 0x6b, 0x02, 0x25, 0xac, 0xfd, 0xa0, 0x95, 0xc1, 0x9d, 0xf1,
+    0xdc, 0xb3, 0xd4, 0xed, 0x7c, 0x4e, 0xc2, 0x46, 0xa6, 0x54, 0xb4, 0x45, 0x5f, 0x5f, 0x78, 0x05,
+    0x17, 0x11, 0x49, 0x73, 0x94, 0xeb, 0xdc, 0x0c, 0xe2, 0x4f, 0x9d, 0x98, 0xe0, 0xeb, 0x30, 0x93,
+    0x45, 0xf1, 0xd5, 0xb4, 0x94, 0xbe, 0x05, 0xb8, 0x2f, 0xce, 0x66, 0x33, 0x37, 0xea, 0xa5, 0x4b,
+    0x4c, 0x8c, 0x47, 0xf5, 0xe0, 0x92, 0x58, 0xd6, 0x60, 0x24, 0xf2, 0xff, 0xcf, 0x38, 0x7b, 0x43,
+    0xc6, 0xc7, 0xe9, 0x6e, 0x6d, 0xba, 0x5b, 0x4a, 0xb7, 0x3d, 0x96, 0xde, 0x87, 0x9c, 0x8d, 0xa0,
+    0x9d, 0x05, 0xed, 0x06, 0xd0, 0x8a, 0xde, 0x0f, 0x89, 0x95, 0x19, 0x95, 0xb5, 0xcb, 0x66, 0x4b,
+    0x3e, 0x0f, 0x3d, 0x0a, 0x13, 0xf0, 0x76, 0x70, 0x7d, 0x0d, 0xaf, 0xfd, 0x47, 0x5e, 0x68, 0xf3,
+    0x12, 0xa8, 0x2f, 0xa8, 0xfc, 0x83, 0x21, 0x1c, 0x47, 0xb1, 0xe3, 0x78, 0xc9, 0x68, 0x1e, 0x80,
+    0xd7, 0x27, 0xe0, 0x14, 0xe6, 0xf4, 0x6f, 0xfd, 0x83, 0xe6, 0x9c, 0x7e, 0x14, 0xd7, 0x71, 0x6d,
+    0x56, 0xc2, 0x24, 0xf9, 0x51, 0x71, 0x1a, 0x6e, 0x51, 0x85, 0xcd, 0x61, 0x30, 0x3d, 0xb7, 0xa9,
+    0x2f, 0xa7, 0x53, 0x97, 0x28, 0x0a, 0x9d, 0x08, 0xb6, 0x0a, 0x73, 0x5d, 0x1b, 0x25, 0x36, 0x48,
+    0x32, 0xf7, 0x92, 0x35, 0x87, 0x61, 0x24, 0xc9, 0xd4, 0x16, 0x8a, 0xe9, 0x74, 0x89, 0x8a, 0xe6,
+    0x65, 0x01, 0x99, 0x28, 0x6a, 0x64, 0x69, 0x53, 0x87, 0xb1, 0x54, 0xa2, 0x6a, 0xef, 0xda, 0xb2,
+    0x4b, 0xaa, 0xa8, 0x2a, 0xd1, 0xc6, 0xdb, 0x2c, 0xc3, 0xca, 0xed, 0x01, 0x5a, 0xb1, 0x1d, 0x5b,
+    0xf5, 0x6e, 0x76, 0x73, 0x34, 0x72, 0x99, 0x6a, 0x8b, 0xd4, 0xf6, 0x23, 0x78, 0x83, 0x75, 0x2d,
+    0xd6, 0x78, 0x8c, 0xc7, 0x43, 0xbf, 0xb3, 0x1b, 0x71, 0x1f, 0xd4, 0x1f, 0x34, 0xdd, 0x17, 0xbf,
+    0xf0, 0x81, 0x1e, 0x86, 0xa9, 0x30, 0x82, 0x3a, 0x2d, 0xed, 0x75, 0x1f, 0x69, 0xcb, 0xd7, 0xd2,
+    0xa0, 0xb1, 0xf3, 0xc1, 0xd5, 0x89, 0x1f, 0x66, 0xd4, 0xf6, 0x34, 0x88, 0x6f, 0x7d, 0xbe, 0x78,
+    0x4e, 0x7e, 0x3d, 0xe9, 0x54, 0xcf, 0x7d, 0x1d, 0xfa, 0x36, 0xa4, 0xa6, 0xe6, 0x7e, 0xe5, 0x23,
+    0xe6, 0xe7, 0x1e, 0x65, 0x9b, 0xdd, 0xa4, 0x79, 0xea, 0xab, 0xf1, 0xbd, 0xfa, 0xf5, 0xa0, 0xee,
+    0x39, 0xc6, 0xb2, 0x2f, 0xe0, 0x37, 0x61, 0xf2, 0x30, 0x41, 0x59, 0x78, 0x3d, 0xf1, 0x14, 0xce,
+    0xdf, 0xf8, 0x43, 0x3b, 0x8f, 0xa3, 0xf8, 0xdf, 0x88, 0x46, 0x8e, 0x57, 0xfd, 0x99, 0x23, 0xfb,
+    0x70, 0x45, 0xfd, 0x14, 0xd8, 0x3a, 0xf4, 0x8a, 0x7d, 0xf7, 0x44, 0x12, 0x1c, 0x9a, 0xd0, 0xff,
+    0xc1, 0xe4, 0xed, 0x77, 0x8e, 0x32, 0x76, 0xf0, 0xb8, 0xbb, 0x7f, 0xac, 0xd8, 0x0e, 0x78, 0x37,
+    0xf8, 0xfc, 0xe0, 0xcb, 0x15, 0x13, 0xad, 0x14, 0x35, 0x26, 0x88, 0xcc, 0x60, 0x05, 0x02, 0xd2,
+    0x4a, 0x97, 0x11, 0xad, 0xf6, 0x43, 0x10, 0x6f, 0x65, 0x61, 0xa0, 0x91, 0x26, 0xd7, 0x5b, 0x63,
+    0xbb, 0xe7, 0xfe, 0xf6, 0x66, 0x75, 0xb3, 0xa4, 0xa0, 0x9e, 0x18, 0xaf, 0x6a, 0xfa, 0x3e, 0xd4,
+    0x43, 0x85, 0x93, 0x42, 0xd7, 0xf8, 0x63, 0x3f, 0xb0, 0xcf, 0xb6, 0x27, 0x7c, 0xa8, 0xd1, 0xdc,
+    0xc9, 0x0d, 0x12, 0x99, 0xd7, 0x75, 0x74, 0x00, 0x34, 0xe7, 0x33, 0xbf, 0xeb, 0x92, 0xbd, 0xf3,
+    0x0d, 0xbc, 0xbb, 0x7a, 0x44, 0x8a, 0x06, 0x00, 0x00,
+};
+
+static const WebAsset webAssets[] = {
+    {"/", "text/html", "\"5cedcc5ee9944422\"", asset_index_html, sizeof(asset_index_html)},
+    {"/live.js", "application/javascript", "\"ec8ae5c6f27a7ead\"", asset_live_js, sizeof(asset_live_js)},
+};
+static const int WEB_ASSET_COUNT = sizeof(webAssets) / sizeof(webAssets[0]);
@@ -0,0 +1,146 @@
+// Runs a partitioned Life board as several processes over loopback and
+// checks the stitched result against a single GameOfLife.
+//
+//   lifenode [--grid 3x2] [--tile 32x8] [--halo 1] [--gens 500] [--seed 1] [--port 47000]
+//
+// Each node prints its per-generation exchange latency.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include "life.h"
+#include "LifeNode.h"
+
+static bool parsePair(const char *s, int &a, int &b)
+{
+    return sscanf(s, "%dx%d", &a, &b) == 2 && a > 0 && b > 0;
+}
+
+int main(int argc, char **argv)
+{
+    int gridW = 3, gridH = 2, tileW = 32, tileH = 8, halo = 1;
+    unsigned int gens = 500;
+    uint32_t seed = 1;
+    int port = 47000;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--grid") && parsePair(argv[i + 1], gridW, gridH))
+            continue;
+        if (!strcmp(argv[i], "--tile") && parsePair(argv[i + 1], tileW, tileH))
+            continue;
+        if (!strcmp(argv[i], "--halo"))
+            halo = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--gens"))
+            gens = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--seed"))
+            seed = strtoul(argv[i + 1], nullptr, 0);
+        else if (!strcmp(argv[i], "--port"))
+            port = atoi(argv[i + 1]);
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    int nodes = gridW * gridH;
+    int width = gridW * tileW, height = gridH * tileH;
+    std::vector<const char *> hosts(nodes, "127.0.0.1");
+
+    GameOfLife global(width, height, true, gens + 1);
+    global.randomize(seed);
+
+    // Each child sends its final tile back through a pipe
+    std::vector<int> pipes(nodes);
+    std::vector<pid_t> children(nodes);
+    for (int n = 0; n < nodes; n++)
+    {
+        int fds[2];
+        if (pipe(fds) < 0)
+            return 1;
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(fds[0]);
+            LifeNode::Config cfg = {gridW, gridH, tileW, tileH, n, halo,
+                                    (uint16_t)port, hosts.data(), 20};
+            LifeNode node(cfg);
+            if (!node.begin())
+            {
+                fprintf(stderr, "node %d: begin failed\n", n);
+                _exit(1);
+            }
+            node.loadTile(global);
+            while (node.getGenerationCount() < gens)
+            {
+                if (!node.advance(5000))
+                {
+                    fprintf(stderr, "node %d: timed out at generation %u\n", n, node.getGenerationCount());
+                    _exit(1);
+                }
+            }
+            // Stay around long enough to answer neighbours' resends
+            for (int i = 0; i < 25; i++)
+                node.service(20);
+
+            const LifeNode::Stats &st = node.getStats();
+            printf("node %d: %u gens, %u exchanges, latency mean %u us max %u us, "
+                   "%.1f us/gen, %u resends, %u bytes sent\n",
+                   n, st.generation, st.exchanges, st.meanExchangeUs(), st.maxExchangeUs,
+                   st.generation ? (double)st.totalExchangeUs / st.generation : 0.0,
+                   st.resends, st.bytesSent);
+            fflush(stdout);
+
+            std::vector<uint8_t> tile(tileW * tileH);
+            for (int y = 0; y < tileH; y++)
+                for (int x = 0; x < tileW; x++)
+                    tile[y * tileW + x] = node.getCell(x, y);
+            if (write(fds[1], tile.data(), tile.size()) != (ssize_t)tile.size())
+                _exit(1);
+            _exit(0);
+        }
+        close(fds[1]);
+        pipes[n] = fds[0];
+        children[n] = pid;
+    }
+
+    for (unsigned int g = 0; g < gens; g++)
+        global.computeNextGeneration();
+
+    int mismatches = 0, failed = 0;
+    for (int n = 0; n < nodes; n++)
+    {
+        std::vector<uint8_t> tile(tileW * tileH);
+        size_t got = 0;
+        ssize_t r;
+        while (got < tile.size() && (r = read(pipes[n], tile.data() + got, tile.size() - got)) > 0)
+            got += r;
+        close(pipes[n]);
+
+        int status = 0;
+        waitpid(children[n], &status, 0);
+        if (got != tile.size() || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            failed++;
+            continue;
+        }
+
+        int ox = (n % gridW) * tileW, oy = (n / gridW) * tileH;
+        for (int y = 0; y < tileH; y++)
+            for (int x = 0; x < tileW; x++)
+                if (tile[y * tileW + x] != global.getCell(ox + x, oy + y))
+                    mismatches++;
+    }
+
+    printf("%dx%d nodes, %dx%d board, halo %d, %u generations: %s",
+           gridW, gridH, width, height, halo, gens,
+           failed ? "FAILED" : (mismatches ? "MISMATCH" : "matches single-board run"));
+    if (mismatches)
+        printf(" (%d cells differ)", mismatches);
+    printf("\n");
+    return failed || mismatches ? 1 : 0;
+}
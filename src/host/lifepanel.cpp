@@ -0,0 +1,188 @@
+// Modelled refresh time of panels from 4 to 256 modules, sent as one chain
+// or split over SPI hosts and bit-banged GPIO chains (PanelChains.h).
+// Every transfer is also shifted through simulated MAX7219s to check that
+// each module ends up showing its rows.
+//
+//   lifepanel [--gens 50] [--spi-mhz 10] [--seed 1]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "PanelChains.h"
+#include "life.h"
+
+struct Layout
+{
+    int wide, high; // In modules
+};
+
+static const Layout LAYOUTS[] = {{4, 1}, {8, 2}, {8, 4}, {8, 8}, {16, 8}, {16, 16}};
+static const int LAYOUT_COUNT = sizeof(LAYOUTS) / sizeof(LAYOUTS[0]);
+
+struct Split
+{
+    const char *name;
+    int spi, gpio;
+};
+
+static const Split SPLITS[] = {{"1 spi", 1, 0}, {"2 spi", 2, 0}, {"2 spi + 2 gpio", 2, 2}, {"2 spi + 6 gpio", 2, 6}};
+static const int SPLIT_COUNT = sizeof(SPLITS) / sizeof(SPLITS[0]);
+
+// What the modules show, from the bytes that reached them
+struct Modules
+{
+    std::vector<PanelChains::Chain> chains;
+    std::vector<int> first;
+    std::vector<uint8_t> rows;
+    uint32_t latches = 0;
+    uint32_t errors = 0;
+};
+
+static void shiftIn(void *context, int chain, const uint8_t *bytes, size_t len)
+{
+    Modules &m = *static_cast<Modules *>(context);
+    int words = (int)len / 2;
+    int modules = m.chains[chain].modules;
+    if (words < modules)
+    {
+        m.errors++;
+        return;
+    }
+    // Sixteen bits per module: once the load pin rises, module p (p = 0
+    // nearest the ESP32) holds the word sent words - 1 - p from the start.
+    // Extra words at the start have fallen out of the far end.
+    for (int p = 0; p < modules; p++)
+    {
+        const uint8_t *w = bytes + 2 * (words - 1 - p);
+        if (w[0] >= 1 && w[0] <= 8)
+            m.rows[(m.first[chain] + p) * 8 + w[0] - 1] = w[1];
+        else if (w[0] == 0)
+            m.errors++; // A no-op reached a real module
+    }
+    m.latches++;
+}
+
+static std::vector<PanelChains::Chain> makeChains(const Split &split, int modules)
+{
+    // As even as possible; pins only matter on the ESP32
+    std::vector<PanelChains::Chain> chains;
+    int count = split.spi + split.gpio;
+    for (int i = 0; i < count; i++)
+    {
+        PanelChains::Chain c;
+        c.kind = i < split.spi ? PanelChains::CHAIN_SPI : PanelChains::CHAIN_GPIO;
+        c.host = i == 0 ? PanelChains::HOST_VSPI : PanelChains::HOST_HSPI;
+        c.clk = 25;
+        c.cs = 26;
+        c.data = (int8_t)(i < split.spi ? 23 : 16 + i);
+        c.modules = (uint16_t)(modules / count + (i < modules % count ? 1 : 0));
+        if (c.modules)
+            chains.push_back(c);
+    }
+    return chains;
+}
+
+// The board's rows into module rows, mapped as LedPanel::drawDeviceRow() does
+static void drawBoard(PanelChains &out, const GameOfLife &life, const Layout &layout)
+{
+    for (int y = 0; y < life.getHeight(); y++)
+    {
+        const uint64_t *row = life.getRow(y);
+        for (int mx = 0; mx < layout.wide; mx++)
+        {
+            uint8_t bits = (uint8_t)(row[mx / 8] >> (8 * (mx % 8)));
+            int module = (layout.high - 1 - y / 8) * layout.wide + (layout.wide - 1 - mx);
+            out.setRow(module, 7 - y % 8, bits);
+        }
+    }
+}
+
+static bool showing(const PanelChains &out, const Modules &m)
+{
+    for (int i = 0; i < out.getModuleCount(); i++)
+    {
+        for (int d = 0; d < 8; d++)
+        {
+            if (m.rows[i * 8 + d] != out.getRow(i, d))
+                return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int gens = 50;
+    uint32_t spiHz = 10000000;
+    uint32_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--gens"))
+            gens = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--spi-mhz"))
+            spiHz = (uint32_t)(atof(argv[i + 1]) * 1000000);
+        else if (!strcmp(argv[i], "--seed"))
+            seed = strtoul(argv[i + 1], nullptr, 0);
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    printf("SPI at %.1f MHz; modelled times, not measured\n", spiHz / 1e6);
+    printf("modules  layout  chains          full frame us    fps  life us/gen    fps  transfers/gen  check\n");
+    bool ok = true;
+    for (int l = 0; l < LAYOUT_COUNT; l++)
+    {
+        const Layout &layout = LAYOUTS[l];
+        int modules = layout.wide * layout.high;
+        for (int s = 0; s < SPLIT_COUNT; s++)
+        {
+            Modules m;
+            m.chains = makeChains(SPLITS[s], modules);
+            PanelChains out(m.chains.data(), (int)m.chains.size(), spiHz);
+            for (int i = 0, first = 0; i < (int)m.chains.size(); i++)
+            {
+                m.first.push_back(first);
+                first += m.chains[i].modules;
+            }
+            m.rows.assign((size_t)modules * 8, 0xFF); // Power up with anything showing
+            out.setTap(shiftIn, &m);
+            out.begin();
+
+            // Every row of every module, as after a clear or an effect
+            GameOfLife life(layout.wide * 8, layout.high * 8);
+            life.randomize(seed);
+            drawBoard(out, life, layout);
+            out.invalidate();
+            out.flush();
+            double fullUs = out.getLastModelNs() / 1000.0;
+            bool good = showing(out, m);
+
+            // A running soup: only rows with a change go out
+            uint64_t lifeNs = 0;
+            uint32_t transfers = out.getTransfers();
+            for (int g = 0; g < gens; g++)
+            {
+                life.computeNextGeneration();
+                drawBoard(out, life, layout);
+                out.flush();
+                lifeNs += out.getLastModelNs();
+                good = good && showing(out, m);
+            }
+            double lifeUs = gens ? lifeNs / 1000.0 / gens : 0;
+            double perGen = gens ? (double)(out.getTransfers() - transfers) / gens : 0;
+            good = good && m.errors == 0;
+            ok = ok && good;
+
+            char shape[16];
+            snprintf(shape, sizeof(shape), "%dx%d", layout.wide, layout.high);
+            printf("%7d  %6s  %-14s  %13.0f  %5.0f  %11.0f  %5.0f  %13.1f  %s\n", modules, shape,
+                   SPLITS[s].name, fullUs, fullUs > 0 ? 1e6 / fullUs : 0, lifeUs,
+                   lifeUs > 0 ? 1e6 / lifeUs : 0, perGen, good ? "ok" : "FAILED");
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+// Record soups and inspect recordings, reading them memory-mapped.
+//
+//   lifeplay record <width>x<height> <seed> <generations> <out> [--keyframe 64]
+//   lifeplay show <file> <frame>
+//   lifeplay verify <file>
+//
+// record stops early if the game finishes. verify plays every frame in
+// order, then seeks to each one directly and checks the two agree.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include "life.h"
+#include "LifeRecording.h"
+
+static int usage()
+{
+    fprintf(stderr, "usage: lifeplay record <width>x<height> <seed> <generations> <out> [--keyframe N]\n"
+                    "       lifeplay show <file> <frame>\n"
+                    "       lifeplay verify <file>\n");
+    return 2;
+}
+
+// Map a recording read-only; the mapping lasts until the process exits
+static bool mapFile(const char *path, const uint8_t *&data, size_t &len)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+    data = (const uint8_t *)map;
+    len = st.st_size;
+    return true;
+}
+
+static bool openPlayer(const char *path, LifePlayer &player)
+{
+    const uint8_t *data;
+    size_t len;
+    if (!mapFile(path, data, len) || !player.open(data, len))
+    {
+        fprintf(stderr, "%s: not a recording\n", path);
+        return false;
+    }
+    return true;
+}
+
+static unsigned long frameHash(const LifePlayer &player)
+{
+    unsigned long hash = 5381;
+    for (int y = 0; y < player.getHeight(); y++)
+    {
+        const uint64_t *row = player.getRow(y);
+        for (int w = 0; w < (player.getWidth() + 63) / 64; w++)
+            hash = hash * 33 + row[w];
+    }
+    return hash;
+}
+
+static int recordSoup(const char *size, uint32_t seed, unsigned int gens, const char *out, unsigned int keyframe)
+{
+    int w, h;
+    if (sscanf(size, "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0)
+        return usage();
+    GameOfLife life(w, h, true, gens);
+    life.randomize(seed);
+
+    LifeRecorder recorder(keyframe);
+    recorder.begin(life);
+    while (!life.isGameFinished())
+    {
+        life.computeNextGeneration();
+        recorder.record(life);
+    }
+    recorder.end();
+
+    printf("%u frames, %zu bytes (%.1f per frame), %.1fx smaller than raw\n",
+           recorder.getFrameCount(), recorder.getStream().size(),
+           (double)recorder.getStream().size() / recorder.getFrameCount(),
+           (double)recorder.getRawBytes() / recorder.getStream().size());
+    if (!recorder.saveFile(out))
+    {
+        perror(out);
+        return 1;
+    }
+    return 0;
+}
+
+static int show(const char *path, unsigned int frame)
+{
+    LifePlayer player;
+    if (!openPlayer(path, player))
+        return 1;
+    if (!player.seek(frame))
+    {
+        fprintf(stderr, "frame %u out of range (%u frames)\n", frame, player.getFrameCount());
+        return 1;
+    }
+    printf("frame %u of %u, generation %u, %dx%d\n", frame, player.getFrameCount(),
+           player.getGeneration(), player.getWidth(), player.getHeight());
+    for (int y = 0; y < player.getHeight(); y++)
+    {
+        for (int x = 0; x < player.getWidth(); x++)
+            putchar(player.getCell(x, y) ? 'O' : '.');
+        putchar('\n');
+    }
+    return 0;
+}
+
+static int verify(const char *path)
+{
+    LifePlayer player;
+    if (!openPlayer(path, player))
+        return 1;
+
+    std::vector<unsigned long> hashes;
+    do
+        hashes.push_back(frameHash(player));
+    while (player.next());
+    if (hashes.size() != player.getFrameCount())
+    {
+        printf("stream ends after %zu of %u frames\n", hashes.size(), player.getFrameCount());
+        return 1;
+    }
+
+    // Backwards, so that every seek starts from a keyframe
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    int bad = 0;
+    for (unsigned int f = player.getFrameCount(); f-- > 0;)
+    {
+        if (!player.seek(f) || frameHash(player) != hashes[f])
+            bad++;
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+    printf("%u frames, keyframe every %u: %s, %.1f us per seek\n", player.getFrameCount(),
+           player.getKeyframeInterval(), bad ? "MISMATCH" : "seeks match playback",
+           us / player.getFrameCount());
+    return bad ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    if ((argc == 6 || argc == 8) && !strcmp(argv[1], "record"))
+    {
+        unsigned int keyframe = 64;
+        if (argc == 8)
+        {
+            if (strcmp(argv[6], "--keyframe"))
+                return usage();
+            keyframe = atoi(argv[7]);
+        }
+        return recordSoup(argv[2], strtoul(argv[3], nullptr, 0), atoi(argv[4]), argv[5], keyframe);
+    }
+    if (argc == 4 && !strcmp(argv[1], "show"))
+        return show(argv[2], atoi(argv[3]));
+    if (argc == 3 && !strcmp(argv[1], "verify"))
+        return verify(argv[2]);
+    return usage();
+}
@@ -0,0 +1,428 @@
+// Runs patterns headless, e.g. to check a pattern library or seed list
+// before it goes to the panels.
+//
+//   liferun [options] <input>...
+//
+// An input is an RLE file, a snapshot (.lsnp), a seed number (random soup),
+// or @list: a file naming one input per line.
+//
+//   --size WxH      Board for RLE patterns and seeds (default 32x8, the panel)
+//   --nowrap        Dead edges instead of a torus
+//   --gens N        Stop after N generations if the game has not finished (default 180)
+//   --jobs N        Worker threads (default: one per core)
+//   --engine NAME   auto, reference, portable, sse2, avx2 or incremental
+//   --curve         Append the population of every generation
+//   --out DIR       Write each final board as DIR/<name>.rle and DIR/<name>.lsnp
+//
+// One line per input, in input order:
+//   name  generations  period  population  peak  ms  [curve]
+// Period is 0 when the generation limit was reached, 1 for a still life.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "life.h"
+#include "LifeSnapshot.h"
+
+struct Options
+{
+    int width = 32;
+    int height = 8;
+    bool wrap = true;
+    unsigned int gens = 180;
+    int jobs = 0;
+    LifeEngine engine = ENGINE_AUTO;
+    bool curve = false;
+    const char *outDir = nullptr;
+};
+
+struct Job
+{
+    std::string input;
+    bool ok = false;
+    std::string error;
+    unsigned int generations = 0;
+    unsigned int period = 0;
+    int population = 0;
+    int peak = 0;
+    double ms = 0;
+    std::vector<int> curve;
+};
+
+static bool isSeed(const std::string &s)
+{
+    char *end;
+    strtoul(s.c_str(), &end, 0);
+    return !s.empty() && isdigit((unsigned char)s[0]) && *end == '\0';
+}
+
+static bool readFile(const char *path, std::string &text)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        text.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+// Standard Life RLE, centred on the board. Only B3/S23 patterns load.
+static bool loadRle(const std::string &text, GameOfLife &life, std::string &error)
+{
+    int w = -1, h = -1;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t eol = text.find('\n', pos);
+        std::string line = text.substr(pos, eol == std::string::npos ? std::string::npos : eol - pos);
+        if (line.empty() || line[0] == '#')
+        {
+            pos = eol == std::string::npos ? text.size() : eol + 1;
+            continue;
+        }
+        if (line[0] == 'x')
+        {
+            if (sscanf(line.c_str(), "x = %d , y = %d", &w, &h) != 2)
+            {
+                error = "bad RLE header";
+                return false;
+            }
+            size_t rule = line.find("rule");
+            if (rule != std::string::npos)
+            {
+                std::string r = line.substr(line.find('=', rule) + 1);
+                r.erase(0, r.find_first_not_of(" \t"));
+                r.erase(r.find_last_not_of(" \t\r") + 1);
+                if (r != "B3/S23" && r != "b3/s23" && r != "23/3")
+                {
+                    error = "rule " + r + " is not B3/S23";
+                    return false;
+                }
+            }
+            pos = eol == std::string::npos ? text.size() : eol + 1;
+        }
+        break;
+    }
+    if (w < 0 || h < 0)
+    {
+        error = "no RLE header";
+        return false;
+    }
+    if (w > life.getWidth() || h > life.getHeight())
+    {
+        error = "pattern larger than the board";
+        return false;
+    }
+
+    int ox = (life.getWidth() - w) / 2, oy = (life.getHeight() - h) / 2;
+    int x = 0, y = 0, count = 0;
+    for (; pos < text.size() && text[pos] != '!'; pos++)
+    {
+        char c = text[pos];
+        if (isdigit((unsigned char)c))
+        {
+            count = count * 10 + (c - '0');
+            continue;
+        }
+        int n = count ? count : 1;
+        count = 0;
+        if (c == 'b' || c == '.')
+            x += n;
+        else if (c == 'o')
+        {
+            for (int i = 0; i < n; i++, x++)
+            {
+                if (x < w && y < h)
+                    life.setCell(ox + x, oy + y, true);
+            }
+        }
+        else if (c == '$')
+        {
+            y += n;
+            x = 0;
+        }
+    }
+    return true;
+}
+
+static bool saveRle(const GameOfLife &life, const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return false;
+    fprintf(f, "x = %d, y = %d, rule = B3/S23\n", life.getWidth(), life.getHeight());
+
+    std::string body;
+    int pendingRows = 0;
+    for (int y = 0; y < life.getHeight(); y++)
+    {
+        // Trailing dead cells of a row are left out
+        int end = life.getWidth();
+        while (end > 0 && !life.getCell(end - 1, y))
+            end--;
+        if (end == 0)
+        {
+            pendingRows++;
+            continue;
+        }
+        if (y > 0)
+        {
+            pendingRows++;
+            body += pendingRows > 1 ? std::to_string(pendingRows) + "$" : "$";
+        }
+        pendingRows = 0;
+        for (int x = 0; x < end;)
+        {
+            bool alive = life.getCell(x, y);
+            int run = 1;
+            while (x + run < end && life.getCell(x + run, y) == alive)
+                run++;
+            if (run > 1)
+                body += std::to_string(run);
+            body += alive ? 'o' : 'b';
+            x += run;
+        }
+    }
+    body += '!';
+    for (size_t i = 0; i < body.size(); i += 70)
+        fprintf(f, "%s\n", body.substr(i, 70).c_str());
+    return fclose(f) == 0;
+}
+
+static std::string baseName(const std::string &input)
+{
+    std::string name = input.substr(input.find_last_of('/') + 1);
+    size_t dot = name.find_last_of('.');
+    return dot == std::string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+static void runJob(Job &job, const Options &opt)
+{
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    GameOfLife *life = nullptr;
+
+    std::string text;
+    if (isSeed(job.input))
+    {
+        life = new GameOfLife(opt.width, opt.height, opt.wrap, opt.gens);
+        life->randomize((uint32_t)strtoul(job.input.c_str(), nullptr, 0));
+    }
+    else if (!readFile(job.input.c_str(), text))
+        job.error = "cannot read";
+    else if (text.compare(0, 4, "LSNP") == 0)
+    {
+        LifeSnapshot::Header h;
+        if (LifeSnapshot::readHeader((const uint8_t *)text.data(), text.size(), h))
+        {
+            life = new GameOfLife(h.width, h.height, h.wrapAround);
+            if (!LifeSnapshot::restore(*life, (const uint8_t *)text.data(), text.size()))
+                job.error = "corrupt or unsupported snapshot";
+        }
+        else
+            job.error = "bad snapshot header";
+    }
+    else
+    {
+        life = new GameOfLife(opt.width, opt.height, opt.wrap, opt.gens);
+        loadRle(text, *life, job.error);
+    }
+
+    if (life && job.error.empty() && !life->setEngine(opt.engine))
+        job.error = "engine not supported or out of memory";
+    if (life && job.error.empty())
+    {
+        int population = life->getPopulation();
+        job.peak = population;
+        if (opt.curve)
+            job.curve.push_back(population);
+
+        // Snapshots keep their own limit; all inputs stop after --gens more
+        unsigned int g = 0;
+        bool finished = false;
+        for (; g < opt.gens; g++)
+        {
+            if ((finished = life->isGameFinished()))
+                break;
+            life->computeNextGeneration();
+            population = life->getPopulation();
+            if (population > job.peak)
+                job.peak = population;
+            if (opt.curve)
+                job.curve.push_back(population);
+        }
+
+        job.generations = g;
+        job.period = finished ? life->getFinalPeriod() : 0;
+        job.population = population;
+        job.ok = true;
+
+        if (opt.outDir)
+        {
+            std::string path = std::string(opt.outDir) + "/" + baseName(job.input);
+            if (!saveRle(*life, (path + ".rle").c_str()) ||
+                !LifeSnapshot::saveFile(*life, (path + ".lsnp").c_str()))
+            {
+                job.ok = false;
+                job.error = "cannot write " + path;
+            }
+        }
+    }
+    delete life;
+    job.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static bool addInput(const std::string &arg, std::vector<Job> &jobs)
+{
+    if (arg[0] != '@')
+    {
+        jobs.push_back(Job());
+        jobs.back().input = arg;
+        return true;
+    }
+    std::string text;
+    if (!readFile(arg.c_str() + 1, text))
+        return false;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t eol = text.find('\n', pos);
+        std::string line = text.substr(pos, eol == std::string::npos ? std::string::npos : eol - pos);
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        line.erase(0, line.find_first_not_of(" \t"));
+        if (!line.empty() && line[0] != '#')
+        {
+            jobs.push_back(Job());
+            jobs.back().input = line;
+        }
+        pos = eol == std::string::npos ? text.size() : eol + 1;
+    }
+    return true;
+}
+
+static bool parseEngine(const char *name, LifeEngine &engine)
+{
+    static const char *const names[] = {"auto", "reference", "portable", "sse2", "avx2", "incremental"};
+    static const LifeEngine engines[] = {ENGINE_AUTO, ENGINE_REFERENCE, ENGINE_PORTABLE,
+                                         ENGINE_SSE2, ENGINE_AVX2, ENGINE_INCREMENTAL};
+    for (int i = 0; i < 6; i++)
+    {
+        if (!strcmp(name, names[i]))
+        {
+            engine = engines[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+static int usage()
+{
+    fprintf(stderr, "usage: liferun [--size WxH] [--nowrap] [--gens N] [--jobs N] [--engine NAME]\n"
+                    "               [--curve] [--out DIR] <input>...\n"
+                    "input: RLE file, snapshot, seed number, or @file listing inputs\n");
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    std::vector<Job> jobs;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--size") && hasValue)
+        {
+            if (sscanf(argv[++i], "%dx%d", &opt.width, &opt.height) != 2 || opt.width <= 0 || opt.height <= 0)
+                return usage();
+        }
+        else if (!strcmp(arg, "--nowrap"))
+            opt.wrap = false;
+        else if (!strcmp(arg, "--gens") && hasValue)
+            opt.gens = strtoul(argv[++i], nullptr, 0);
+        else if (!strcmp(arg, "--jobs") && hasValue)
+            opt.jobs = atoi(argv[++i]);
+        else if (!strcmp(arg, "--engine") && hasValue)
+        {
+            if (!parseEngine(argv[++i], opt.engine))
+                return usage();
+            // Rather than every input failing the same way
+            GameOfLife probe(64, 1);
+            if (!probe.setEngine(opt.engine))
+            {
+                fprintf(stderr, "%s: engine not supported on this CPU\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (!strcmp(arg, "--curve"))
+            opt.curve = true;
+        else if (!strcmp(arg, "--out") && hasValue)
+            opt.outDir = argv[++i];
+        else if (arg[0] == '-' && arg[1] == '-')
+            return usage();
+        else if (!addInput(arg, jobs))
+        {
+            fprintf(stderr, "%s: cannot read list\n", arg + 1);
+            return 1;
+        }
+    }
+    if (jobs.empty())
+        return usage();
+
+    int workers = opt.jobs > 0 ? opt.jobs : (int)std::thread::hardware_concurrency();
+    if (workers < 1)
+        workers = 1;
+    if (workers > (int)jobs.size())
+        workers = jobs.size();
+
+    // Workers take the next input as they finish one, so long runs do not hold up the rest
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers; w++)
+    {
+        threads.push_back(std::thread([&]()
+                                      {
+                                          for (size_t j; (j = next++) < jobs.size();)
+                                              runJob(jobs[j], opt);
+                                      }));
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    int failed = 0;
+    unsigned long long generations = 0;
+    for (size_t j = 0; j < jobs.size(); j++)
+    {
+        const Job &job = jobs[j];
+        if (!job.ok)
+        {
+            printf("%s\terror: %s\n", job.input.c_str(), job.error.c_str());
+            failed++;
+            continue;
+        }
+        generations += job.generations;
+        printf("%s\t%u\t%u\t%d\t%d\t%.3f", job.input.c_str(), job.generations, job.period,
+               job.population, job.peak, job.ms);
+        if (opt.curve)
+        {
+            putchar('\t');
+            for (size_t g = 0; g < job.curve.size(); g++)
+                printf(g ? ",%d" : "%d", job.curve[g]);
+        }
+        putchar('\n');
+    }
+    fprintf(stderr, "%zu inputs, %d failed, %llu generations in %.1f ms on %d threads\n",
+            jobs.size(), failed, generations, totalMs, workers);
+    return failed ? 1 : 0;
+}
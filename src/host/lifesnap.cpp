@@ -0,0 +1,114 @@
+// Inspect, create and advance board snapshots, e.g. one fetched from a
+// panel with  curl http://<panel>/snapshot -o board.lsnp
+//
+//   lifesnap info <file>
+//   lifesnap new <width>x<height> <seed> <file> [--nowrap]
+//   lifesnap run <in> <generations> <out>
+//
+// run stops early if the game finishes, as it would on the panel.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+#include "LifeSnapshot.h"
+
+static int usage()
+{
+    fprintf(stderr, "usage: lifesnap info <file>\n"
+                    "       lifesnap new <width>x<height> <seed> <file> [--nowrap]\n"
+                    "       lifesnap run <in> <generations> <out>\n");
+    return 2;
+}
+
+static int info(const char *path)
+{
+    MappedSnapshot snap;
+    if (!snap.open(path))
+    {
+        fprintf(stderr, "%s: not a snapshot\n", path);
+        return 1;
+    }
+    const LifeSnapshot::Header &h = snap.header();
+
+    long population = 0;
+    for (uint32_t y = 0; y < h.height; y++)
+    {
+        const uint64_t *row = snap.getRow(y);
+        for (uint32_t w = 0; w < h.wordsPerRow(); w++)
+            population += __builtin_popcountll(row[w]);
+    }
+
+    printf("version     %u\n", h.version);
+    printf("board       %ux%u%s\n", h.width, h.height, h.wrapAround ? " wrap-around" : "");
+    printf("rule        B%s/S%s\n", h.birthMask == LifeSnapshot::BIRTH_B3 ? "3" : "?",
+           h.survivalMask == LifeSnapshot::SURVIVAL_S23 ? "23" : "?");
+    printf("generation  %u of %u\n", h.generation, h.maxGenerations);
+    printf("period      %u\n", h.finalPeriod);
+    printf("seed        %u\n", h.seed);
+    printf("population  %ld\n", population);
+    printf("history     %u hashes (%u-bit)\n", h.historyCount, h.hashBits);
+    return 0;
+}
+
+static int create(const char *size, uint32_t seed, const char *path, bool wrap)
+{
+    int w, h;
+    if (sscanf(size, "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0)
+        return usage();
+    GameOfLife life(w, h, wrap);
+    life.randomize(seed);
+    if (!LifeSnapshot::saveFile(life, path))
+    {
+        perror(path);
+        return 1;
+    }
+    return 0;
+}
+
+static int run(const char *in, unsigned int gens, const char *out)
+{
+    MappedSnapshot snap;
+    if (!snap.open(in))
+    {
+        fprintf(stderr, "%s: not a snapshot\n", in);
+        return 1;
+    }
+    const LifeSnapshot::Header &h = snap.header();
+    GameOfLife life(h.width, h.height, h.wrapAround, h.maxGenerations);
+    if (!snap.restore(life))
+    {
+        fprintf(stderr, "%s: corrupt or unsupported snapshot\n", in);
+        return 1;
+    }
+    snap.close();
+
+    unsigned int g = 0;
+    for (; g < gens; g++)
+    {
+        if (life.isGameFinished())
+            break;
+        life.computeNextGeneration();
+    }
+    printf("ran %u generations to %u, population %d%s\n", g, life.getGenerationCount(),
+           life.getPopulation(), g < gens ? ", finished" : "");
+
+    if (!LifeSnapshot::saveFile(life, out))
+    {
+        perror(out);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 3 && !strcmp(argv[1], "info"))
+        return info(argv[2]);
+    if ((argc == 5 || argc == 6) && !strcmp(argv[1], "new"))
+        return create(argv[2], strtoul(argv[3], nullptr, 0), argv[4],
+                      !(argc == 6 && !strcmp(argv[5], "--nowrap")));
+    if (argc == 5 && !strcmp(argv[1], "run"))
+        return run(argv[2], strtoul(argv[3], nullptr, 0), argv[4]);
+    return usage();
+}
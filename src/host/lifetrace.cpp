@@ -0,0 +1,181 @@
+// Turns a trace dump (LifeTrace.h) into Chrome trace JSON, for
+// ui.perfetto.dev or chrome://tracing, with one track per core.
+//
+//   curl http://<panel>/trace > trace.txt
+//   lifetrace trace.txt > trace.json
+//
+// A serial capture works too: other output is skipped, and of several
+// dumps the last one is used. Also prints how often each span ran and how
+// long it took.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+struct Event
+{
+    int64_t timeUs; // Unwrapped, from the earliest event
+    unsigned core;
+    char phase;
+    std::string name;
+    unsigned arg;
+};
+
+struct Span
+{
+    uint32_t count = 0;
+    int64_t totalUs = 0;
+    int64_t maxUs = 0;
+};
+
+static bool readDump(FILE *in, std::vector<Event> &events, uint32_t &lost)
+{
+    char line[256];
+    bool found = false;
+    int64_t last = 0;
+    while (fgets(line, sizeof(line), in))
+    {
+        const char *start = strstr(line, "# lifetrace ");
+        if (start)
+        {
+            // A later dump replaces an earlier one
+            events.clear();
+            found = true;
+            lost = 0;
+            continue;
+        }
+        unsigned written, missing;
+        start = strstr(line, "# end, ");
+        if (start && sscanf(start, "# end, %u events, %u lost", &written, &missing) == 2)
+        {
+            lost = missing;
+            continue;
+        }
+        if (!found)
+            continue;
+
+        unsigned timeUs, core, arg;
+        char phase;
+        char name[64];
+        if (sscanf(line, "%u %u %c %63s %u", &timeUs, &core, &phase, name, &arg) != 5 ||
+            (phase != 'B' && phase != 'E' && phase != 'I'))
+            continue;
+
+        // The clock is 32 bits of microseconds, and wraps every 71 minutes.
+        // Events from two cores can arrive slightly out of order.
+        int64_t t = (int64_t)timeUs;
+        if (!events.empty())
+        {
+            int64_t wraps = (last - t + ((int64_t)1 << 31)) >> 32;
+            t += wraps << 32;
+        }
+        last = t;
+        Event e;
+        e.timeUs = t;
+        e.core = core;
+        e.phase = phase;
+        e.name = name;
+        e.arg = arg;
+        events.push_back(e);
+    }
+
+    int64_t first = last;
+    for (size_t i = 0; i < events.size(); i++)
+        first = events[i].timeUs < first ? events[i].timeUs : first;
+    for (size_t i = 0; i < events.size(); i++)
+        events[i].timeUs -= first;
+    return found;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: lifetrace <dump.txt | ->  > trace.json\n");
+        return 2;
+    }
+    FILE *in = strcmp(argv[1], "-") ? fopen(argv[1], "r") : stdin;
+    if (!in)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    std::vector<Event> events;
+    uint32_t lost = 0;
+    bool found = readDump(in, events, lost);
+    if (in != stdin)
+        fclose(in);
+    if (!found)
+    {
+        fprintf(stderr, "%s: no trace dump\n", argv[1]);
+        return 1;
+    }
+
+    // An end whose begin was overwritten is dropped, and a span still open
+    // at the end of the dump is closed there, so every track nests
+    std::map<unsigned, std::vector<size_t>> open;
+    std::vector<bool> keep(events.size(), true);
+    std::map<std::string, Span> spans;
+    int64_t endUs = events.empty() ? 0 : events.back().timeUs;
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const Event &e = events[i];
+        endUs = e.timeUs > endUs ? e.timeUs : endUs;
+        std::vector<size_t> &stack = open[e.core];
+        if (e.phase == 'B')
+            stack.push_back(i);
+        else if (e.phase == 'E')
+        {
+            if (stack.empty() || events[stack.back()].name != e.name)
+            {
+                keep[i] = false;
+                continue;
+            }
+            Span &s = spans[e.name];
+            int64_t us = e.timeUs - events[stack.back()].timeUs;
+            s.count++;
+            s.totalUs += us;
+            s.maxUs = us > s.maxUs ? us : s.maxUs;
+            stack.pop_back();
+        }
+    }
+
+    printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ESP32\"}}");
+    for (std::map<unsigned, std::vector<size_t>>::iterator it = open.begin(); it != open.end(); ++it)
+        printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"core %u\"}}",
+               it->first, it->first);
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const Event &e = events[i];
+        if (!keep[i])
+            continue;
+        printf(",\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%lld,\"pid\":1,\"tid\":%u", e.name.c_str(),
+               e.phase == 'I' ? "i\",\"s\":\"t" : e.phase == 'B' ? "B" : "E", (long long)e.timeUs, e.core);
+        if (e.phase != 'E')
+            printf(",\"args\":{\"arg\":%u}", e.arg);
+        printf("}");
+    }
+    for (std::map<unsigned, std::vector<size_t>>::iterator it = open.begin(); it != open.end(); ++it)
+    {
+        for (size_t j = it->second.size(); j-- > 0;)
+            printf(",\n{\"name\":\"%s\",\"ph\":\"E\",\"ts\":%lld,\"pid\":1,\"tid\":%u}",
+                   events[it->second[j]].name.c_str(), (long long)endUs, it->first);
+    }
+    printf("\n]}\n");
+
+    fprintf(stderr, "%zu events over %.1f ms, %u lost to the ring\n", events.size(), endUs / 1000.0,
+            (unsigned)lost);
+    fprintf(stderr, "span                count     total us    mean us     max us\n");
+    for (std::map<std::string, Span>::iterator it = spans.begin(); it != spans.end(); ++it)
+    {
+        const Span &s = it->second;
+        fprintf(stderr, "%-18s %6u %12lld %10.1f %10lld\n", it->first.c_str(), (unsigned)s.count,
+                (long long)s.totalUs, (double)s.totalUs / s.count, (long long)s.maxUs);
+    }
+    return 0;
+}
@@ -0,0 +1,664 @@
+// Differential check of every faster way of stepping a board against
+// ENGINE_REFERENCE, the original per-cell loop, and of the unbounded plane
+// against a dead-edged board too big to reach the edges of. Seeded random boards of
+// random and awkward sizes (widths either side of multiples of 8 and 64,
+// one-row and one-column boards), wrapped and not, are run to the end of
+// their game. Every generation the board, its hash, the generation count,
+// the statistics and the finish decision and period must match.
+//
+// The first case each subject fails is shrunk (a later start, fewer rows
+// and columns, fewer live cells, a lower generation limit) while it still
+// fails, and printed as RLE that liferun can replay.
+//
+//   lifeverify [--cases 10000] [--seed 1] [--jobs N] [--only NAME] [--case N]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LifeBatch.h"
+#include "SparseLife.h"
+#include "life.h"
+
+enum Mode
+{
+    MODE_STEP,  // isGameFinished() and computeNextGeneration(), as the display runs
+    MODE_TOGGLE, // The same, turning statistics on and off between the two
+    MODE_STEPN, // stepN() in chunks; no finish checks
+    MODE_BATCH32,
+    MODE_BATCH64,
+    MODE_SPARSE // SparseLife, from the case's board at the origin
+};
+
+struct Subject
+{
+    const char *name;
+    Mode mode;
+    LifeEngine engine;
+};
+
+static const Subject SUBJECTS[] = {
+    {"portable", MODE_STEP, ENGINE_PORTABLE},
+    {"sse2", MODE_STEP, ENGINE_SSE2},
+    {"avx2", MODE_STEP, ENGINE_AVX2},
+    {"incremental", MODE_STEP, ENGINE_INCREMENTAL},
+    {"portable-toggle", MODE_TOGGLE, ENGINE_PORTABLE},
+    {"incremental-toggle", MODE_TOGGLE, ENGINE_INCREMENTAL},
+    {"stepN", MODE_STEPN, ENGINE_AUTO},
+    {"stepN-portable", MODE_STEPN, ENGINE_PORTABLE},
+    {"stepN-incremental", MODE_STEPN, ENGINE_INCREMENTAL},
+    {"batch32", MODE_BATCH32, ENGINE_REFERENCE},
+    {"batch64", MODE_BATCH64, ENGINE_REFERENCE},
+    {"sparse", MODE_SPARSE, ENGINE_REFERENCE},
+};
+static const int SUBJECT_COUNT = sizeof(SUBJECTS) / sizeof(SUBJECTS[0]);
+
+// Widths and heights that sit on or either side of a word or byte boundary
+static const int EDGE_WIDTHS[] = {1, 2, 3, 7, 8, 9, 31, 32, 33, 63, 64, 65, 127, 128, 129, 191, 192, 193};
+static const int EDGE_HEIGHTS[] = {1, 2, 3, 4, 7, 8, 9, 16, 17};
+
+// The plane's reference board grows with the generation limit, so keep it short
+static const unsigned int SPARSE_GENS = 32;
+
+struct Case
+{
+    int width;
+    int height;
+    bool wrap;
+    unsigned int maxGen;
+    uint64_t chunkSeed;         // stepN() chunk lengths
+    std::vector<uint8_t> cells; // Row by row
+};
+
+struct Divergence
+{
+    unsigned int generation;
+    std::string what;
+};
+
+// The reference run: the board at every generation, and how the game ended
+struct Trace
+{
+    int wordsPerRow;
+    std::vector<std::vector<uint64_t>> boards;
+    std::vector<unsigned long> hashes;
+    unsigned int period;
+};
+
+static uint64_t splitmix(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static Case makeCase(uint64_t seed, uint64_t index)
+{
+    uint64_t state = seed * 0x2545F4914F6CDD1DULL + index;
+    Case c;
+    if (splitmix(state) % 2)
+    {
+        c.width = EDGE_WIDTHS[splitmix(state) % (sizeof(EDGE_WIDTHS) / sizeof(EDGE_WIDTHS[0]))];
+        c.height = EDGE_HEIGHTS[splitmix(state) % (sizeof(EDGE_HEIGHTS) / sizeof(EDGE_HEIGHTS[0]))];
+    }
+    else
+    {
+        c.width = 1 + splitmix(state) % 80;
+        c.height = 1 + splitmix(state) % 24;
+    }
+    c.wrap = splitmix(state) % 4 != 0;
+    c.maxGen = 1 + splitmix(state) % 150;
+    c.chunkSeed = splitmix(state);
+
+    // Anything from a few cells to a crowd, sometimes in one patch
+    uint64_t density = 1 + splitmix(state) % 15; // Sixteenths
+    int x0 = 0, y0 = 0, x1 = c.width, y1 = c.height;
+    if (splitmix(state) % 3 == 0)
+    {
+        x0 = splitmix(state) % c.width;
+        y0 = splitmix(state) % c.height;
+        x1 = x0 + 1 + splitmix(state) % 8;
+        y1 = y0 + 1 + splitmix(state) % 8;
+    }
+    c.cells.assign((size_t)c.width * c.height, 0);
+    for (int y = y0; y < y1 && y < c.height; y++)
+    {
+        for (int x = x0; x < x1 && x < c.width; x++)
+            c.cells[y * c.width + x] = splitmix(state) % 16 < density;
+    }
+    return c;
+}
+
+static void load(const Case &c, GameOfLife &life)
+{
+    for (int y = 0; y < c.height; y++)
+    {
+        for (int x = 0; x < c.width; x++)
+            life.setCell(x, y, c.cells[y * c.width + x] != 0);
+    }
+}
+
+static std::vector<uint64_t> rowsOf(const GameOfLife &life)
+{
+    const uint64_t *rows = life.getRow(0);
+    return std::vector<uint64_t>(rows, rows + life.getWordsPerRow() * life.getHeight());
+}
+
+static Trace runReference(const Case &c)
+{
+    GameOfLife ref(c.width, c.height, c.wrap, c.maxGen);
+    ref.setEngine(ENGINE_REFERENCE);
+    load(c, ref);
+    Trace t;
+    t.wordsPerRow = ref.getWordsPerRow();
+    for (;;)
+    {
+        t.boards.push_back(rowsOf(ref));
+        t.hashes.push_back(ref.calculateBoardHash());
+        if (ref.isGameFinished())
+            break;
+        ref.computeNextGeneration();
+    }
+    t.period = ref.getFinalPeriod();
+    return t;
+}
+
+// The statistics worked out the slow way from the reference boards
+static std::string checkStats(GameOfLife &life, const Case &c, const Trace &t, size_t g, bool changes)
+{
+    const std::vector<uint64_t> &now = t.boards[g];
+    const std::vector<uint64_t> &before = t.boards[g ? g - 1 : 0];
+    int population = 0, births = 0, deaths = 0;
+    int minX = c.width, minY = c.height, maxX = -1, maxY = -1;
+    for (int y = 0; y < c.height; y++)
+    {
+        for (int x = 0; x < c.width; x++)
+        {
+            size_t w = y * t.wordsPerRow + x / 64;
+            bool alive = (now[w] >> (x % 64)) & 1;
+            bool was = (before[w] >> (x % 64)) & 1;
+            population += alive;
+            births += alive && !was;
+            deaths += was && !alive;
+            if (alive)
+            {
+                minX = x < minX ? x : minX;
+                maxX = x > maxX ? x : maxX;
+                minY = y < minY ? y : minY;
+                maxY = y > maxY ? y : maxY;
+            }
+        }
+    }
+    const LifeStats &s = life.getStats();
+    char what[160];
+    what[0] = '\0';
+    if (s.population != population || life.getPopulation() != population)
+        snprintf(what, sizeof(what), "population %d, reference %d", s.population, population);
+    else if (s.minX != minX || s.minY != minY || s.maxX != maxX || s.maxY != maxY)
+        snprintf(what, sizeof(what), "box %d,%d to %d,%d, reference %d,%d to %d,%d", s.minX, s.minY, s.maxX,
+                 s.maxY, minX, minY, maxX, maxY);
+    else if (changes && (s.births != births || s.deaths != deaths))
+        snprintf(what, sizeof(what), "%d births %d deaths, reference %d and %d", s.births, s.deaths, births,
+                 deaths);
+    return what;
+}
+
+static bool differs(Divergence *d, unsigned int generation, const std::string &what)
+{
+    if (d)
+    {
+        d->generation = generation;
+        d->what = what;
+    }
+    return true;
+}
+
+static bool runStep(const Case &c, const Subject &s, const Trace &t, Divergence *d)
+{
+    GameOfLife life(c.width, c.height, c.wrap, c.maxGen);
+    life.setEngine(s.engine);
+    life.setStatsTracking(true);
+    load(c, life);
+    bool tracked = true; // During the step to this generation
+    for (size_t g = 0;; g++)
+    {
+        if (rowsOf(life) != t.boards[g])
+            return differs(d, g, "board");
+        if (life.calculateBoardHash() != t.hashes[g])
+            return differs(d, g, "board hash");
+        if (life.getGenerationCount() != g)
+            return differs(d, g, "generation count " + std::to_string(life.getGenerationCount()));
+        // Untracked, getStats() counts the board, but cannot know what changed
+        std::string stats = checkStats(life, c, t, g, g > 0 && tracked);
+        if (!stats.empty())
+            return differs(d, g, stats);
+
+        bool finished = life.isGameFinished();
+        bool refFinished = g + 1 == t.boards.size();
+        if (finished != refFinished)
+            return differs(d, g, finished ? "finished early" : "did not finish");
+        if (finished)
+        {
+            if (life.getFinalPeriod() != t.period)
+                return differs(d, g, "final period " + std::to_string(life.getFinalPeriod()) + ", reference " +
+                                         std::to_string(t.period));
+            return false;
+        }
+        if (s.mode == MODE_TOGGLE)
+        {
+            // After isGameFinished() has worked out the next generation
+            tracked = g % 3 != 1;
+            life.setStatsTracking(tracked);
+        }
+        life.computeNextGeneration();
+    }
+}
+
+static bool runStepN(const Case &c, const Subject &s, const Trace &t, Divergence *d)
+{
+    GameOfLife life(c.width, c.height, c.wrap, c.maxGen);
+    life.setEngine(s.engine);
+    life.setStatsTracking(true);
+    load(c, life);
+    uint64_t state = c.chunkSeed;
+    size_t g = 0;
+    while (g + 1 < t.boards.size())
+    {
+        // Up to twice the deepest pass, so chunks split into several
+        unsigned int k = 1 + splitmix(state) % 70;
+        if (g + k >= t.boards.size())
+            k = t.boards.size() - 1 - g;
+        life.stepN(k);
+        g += k;
+        if (rowsOf(life) != t.boards[g])
+            return differs(d, g, "board after stepN(" + std::to_string(k) + ")");
+        if (life.calculateBoardHash() != t.hashes[g])
+            return differs(d, g, "board hash");
+        if (life.getGenerationCount() != g)
+            return differs(d, g, "generation count " + std::to_string(life.getGenerationCount()));
+        // Births and deaths cover only stepN()'s last pass
+        std::string stats = checkStats(life, c, t, g, false);
+        if (!stats.empty())
+            return differs(d, g, stats);
+    }
+    return false;
+}
+
+template <typename Word>
+static bool runBatch(const Case &c, const Trace &t, uint64_t noise, Divergence *d)
+{
+    // The case in one lane, other soups in the rest, which must not leak into it
+    LifeBatch<Word> batch(c.width, c.height, c.wrap, c.maxGen);
+    int lane = noise % LifeBatch<Word>::LANES;
+    for (int l = 0; l < LifeBatch<Word>::LANES; l++)
+        batch.randomize(l, (uint32_t)(noise >> 8) + l);
+    GameOfLife board(c.width, c.height, c.wrap, c.maxGen);
+    load(c, board);
+    batch.loadBoard(lane, board);
+
+    for (size_t g = 0;; g++)
+    {
+        for (int y = 0; y < c.height; y++)
+        {
+            for (int x = 0; x < c.width; x++)
+            {
+                bool ref = (t.boards[g][y * t.wordsPerRow + x / 64] >> (x % 64)) & 1;
+                if (batch.getCell(lane, x, y) != ref)
+                    return differs(d, g, "board at " + std::to_string(x) + "," + std::to_string(y));
+            }
+        }
+        if (batch.calculateBoardHash(lane) != t.hashes[g])
+            return differs(d, g, "board hash");
+        if (batch.getGenerationCount(lane) != g)
+            return differs(d, g, "generation count " + std::to_string(batch.getGenerationCount(lane)));
+
+        bool active = (batch.advance() >> lane) & 1;
+        bool refFinished = g + 1 == t.boards.size();
+        if (active == refFinished)
+            return differs(d, g, active ? "did not finish" : "finished early");
+        if (!active)
+        {
+            if (batch.getFinalPeriod(lane) != t.period)
+                return differs(d, g, "final period " + std::to_string(batch.getFinalPeriod(lane)) +
+                                         ", reference " + std::to_string(t.period));
+            return false;
+        }
+    }
+}
+
+// Nothing spreads faster than a cell a generation, so a dead-edged board
+// with that much room round the case runs as the plane does
+static Case padded(const Case &c)
+{
+    Case p;
+    p.maxGen = c.maxGen < SPARSE_GENS ? c.maxGen : SPARSE_GENS;
+    int pad = p.maxGen + 1;
+    p.width = c.width + 2 * pad;
+    p.height = c.height + 2 * pad;
+    p.wrap = false;
+    p.chunkSeed = c.chunkSeed;
+    p.cells.assign((size_t)p.width * p.height, 0);
+    for (int y = 0; y < c.height; y++)
+    {
+        for (int x = 0; x < c.width; x++)
+            p.cells[(y + pad) * p.width + x + pad] = c.cells[y * c.width + x];
+    }
+    return p;
+}
+
+static bool runSparse(const Case &c, Divergence *d)
+{
+    Case p = padded(c);
+    Trace t = runReference(p);
+    int pad = p.maxGen + 1;
+    SparseLife plane(p.maxGen, 1 << 20);
+    for (int y = 0; y < c.height; y++)
+    {
+        for (int x = 0; x < c.width; x++)
+        {
+            if (c.cells[y * c.width + x])
+                plane.setCell(x, y, true);
+        }
+    }
+
+    for (size_t g = 0;; g++)
+    {
+        int population = 0;
+        int minX = INT32_MAX, minY = INT32_MAX, maxX = INT32_MIN, maxY = INT32_MIN;
+        for (int y = 0; y < p.height; y++)
+        {
+            for (int x = 0; x < p.width; x++)
+            {
+                if (!((t.boards[g][y * t.wordsPerRow + x / 64] >> (x % 64)) & 1))
+                    continue;
+                if (!plane.getCell(x - pad, y - pad))
+                    return differs(d, g, "cell " + std::to_string(x - pad) + "," + std::to_string(y - pad) +
+                                             " is dead");
+                population++;
+                minX = x - pad < minX ? x - pad : minX;
+                maxX = x - pad > maxX ? x - pad : maxX;
+                minY = y - pad < minY ? y - pad : minY;
+                maxY = y - pad > maxY ? y - pad : maxY;
+            }
+        }
+        if (plane.getPopulation() != population)
+            return differs(d, g, "population " + std::to_string(plane.getPopulation()) + ", reference " +
+                                     std::to_string(population));
+        int32_t x0, y0, x1, y1;
+        if (population && (!plane.getBoundingBox(x0, y0, x1, y1) || x0 != minX || y0 != minY || x1 != maxX ||
+                           y1 != maxY))
+            return differs(d, g, "bounding box");
+        if (plane.getGenerationCount() != g)
+            return differs(d, g, "generation count " + std::to_string(plane.getGenerationCount()));
+
+        bool finished = plane.isGameFinished();
+        bool refFinished = g + 1 == t.boards.size();
+        if (finished != refFinished)
+            return differs(d, g, finished ? "finished early" : "did not finish");
+        if (finished)
+        {
+            if (plane.getFinalPeriod() != t.period)
+                return differs(d, g, "final period " + std::to_string(plane.getFinalPeriod()) + ", reference " +
+                                         std::to_string(t.period));
+            return false;
+        }
+        plane.computeNextGeneration();
+    }
+}
+
+static bool diverges(const Case &c, const Subject &s, const Trace &t, Divergence *d)
+{
+    switch (s.mode)
+    {
+    case MODE_STEP:
+    case MODE_TOGGLE:
+        return runStep(c, s, t, d);
+    case MODE_STEPN:
+        return runStepN(c, s, t, d);
+    case MODE_BATCH32:
+        return runBatch<uint32_t>(c, t, c.chunkSeed, d);
+    case MODE_BATCH64:
+        return runBatch<uint64_t>(c, t, c.chunkSeed, d);
+    default:
+        return runSparse(c, d);
+    }
+}
+
+static bool diverges(const Case &c, const Subject &s, Divergence *d)
+{
+    return diverges(c, s, runReference(c), d);
+}
+
+static int liveCells(const Case &c)
+{
+    int n = 0;
+    for (size_t i = 0; i < c.cells.size(); i++)
+        n += c.cells[i];
+    return n;
+}
+
+// Greedy: keep any simplification that still fails, until none does
+static Case shrink(Case c, const Subject &s)
+{
+    Divergence d;
+    diverges(c, s, &d);
+    for (bool progress = true; progress;)
+    {
+        progress = false;
+
+        // Start from a later reference board, and stop sooner
+        for (unsigned int skip : {d.generation, d.generation / 2, 1u})
+        {
+            if (skip == 0 || skip >= c.maxGen)
+                continue;
+            GameOfLife ref(c.width, c.height, c.wrap, c.maxGen);
+            ref.setEngine(ENGINE_REFERENCE);
+            load(c, ref);
+            for (unsigned int g = 0; g < skip; g++)
+                ref.computeNextGeneration();
+            Case t = c;
+            t.maxGen -= skip;
+            for (int i = 0; i < c.width * c.height; i++)
+                t.cells[i] = ref.getCell(i % c.width, i / c.width);
+            if (diverges(t, s, &d))
+            {
+                c = t;
+                progress = true;
+                break;
+            }
+        }
+        if (d.generation + 1 < c.maxGen)
+        {
+            Case t = c;
+            t.maxGen = d.generation + 1;
+            if (diverges(t, s, nullptr))
+            {
+                c = t;
+                progress = true;
+            }
+        }
+
+        // Drop an edge row or column
+        for (int edge = 0; edge < 4; edge++)
+        {
+            bool column = edge < 2;
+            if ((column ? c.width : c.height) <= 1)
+                continue;
+            Case t = c;
+            column ? t.width-- : t.height--;
+            t.cells.clear();
+            for (int y = 0; y < c.height; y++)
+            {
+                for (int x = 0; x < c.width; x++)
+                {
+                    bool dropped = column ? x == (edge == 0 ? 0 : c.width - 1) : y == (edge == 2 ? 0 : c.height - 1);
+                    if (!dropped)
+                        t.cells.push_back(c.cells[y * c.width + x]);
+                }
+            }
+            if (diverges(t, s, nullptr))
+            {
+                c = t;
+                progress = true;
+            }
+        }
+
+        // Clear live cells, in halves, then quarters, down to one at a time
+        std::vector<int> live;
+        for (size_t i = 0; i < c.cells.size(); i++)
+        {
+            if (c.cells[i])
+                live.push_back(i);
+        }
+        for (size_t chunk = live.size() / 2; chunk >= 1; chunk /= 2)
+        {
+            for (size_t from = 0; from < live.size(); from += chunk)
+            {
+                Case t = c;
+                for (size_t j = from; j < from + chunk && j < live.size(); j++)
+                    t.cells[live[j]] = 0;
+                if (liveCells(t) < liveCells(c) && diverges(t, s, nullptr))
+                {
+                    c = t;
+                    progress = true;
+                }
+            }
+        }
+        diverges(c, s, &d);
+    }
+    return c;
+}
+
+static void printRepro(const Case &c, const Subject &s)
+{
+    Divergence d;
+    diverges(c, s, &d);
+    printf("  minimal: %dx%d %s, generation limit %u, %d live cells; differs at generation %u: %s\n", c.width,
+           c.height, c.wrap ? "wrapped" : "dead edges", c.maxGen, liveCells(c), d.generation, d.what.c_str());
+    // liferun runs the display's loop, so only those subjects replay there;
+    // for the plane it shows the reference's side
+    Case run = s.mode == MODE_SPARSE ? padded(c) : c;
+    for (const char *engine : {"reference", s.mode == MODE_STEP ? s.name : nullptr})
+    {
+        if (engine)
+            printf("  liferun --size %dx%d%s --gens %u --engine %s repro.rle\n", run.width, run.height,
+                   run.wrap ? "" : " --nowrap", run.maxGen, engine);
+    }
+    printf("x = %d, y = %d, rule = B3/S23\n", c.width, c.height);
+    for (int y = 0; y < c.height; y++)
+    {
+        for (int x = 0; x < c.width; x++)
+            putchar(c.cells[y * c.width + x] ? 'o' : 'b');
+        putchar(y + 1 < c.height ? '$' : '!');
+        putchar('\n');
+    }
+}
+
+static bool supported(const Subject &s)
+{
+    GameOfLife probe(8, 8);
+    return probe.setEngine(s.engine);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t cases = 10000;
+    uint64_t seed = 1;
+    int jobs = 0;
+    const char *only = nullptr;
+    long long single = -1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--cases"))
+            cases = strtoull(argv[i + 1], nullptr, 0);
+        else if (!strcmp(argv[i], "--seed"))
+            seed = strtoull(argv[i + 1], nullptr, 0);
+        else if (!strcmp(argv[i], "--jobs"))
+            jobs = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--only"))
+            only = argv[i + 1];
+        else if (!strcmp(argv[i], "--case"))
+            single = strtoll(argv[i + 1], nullptr, 0);
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::vector<const Subject *> subjects;
+    for (int s = 0; s < SUBJECT_COUNT; s++)
+    {
+        if (only && strcmp(only, SUBJECTS[s].name))
+            continue;
+        if (supported(SUBJECTS[s]))
+            subjects.push_back(&SUBJECTS[s]);
+        else
+            printf("%-18s not supported on this CPU\n", SUBJECTS[s].name);
+    }
+    uint64_t first = single >= 0 ? (uint64_t)single : 0;
+    uint64_t end = single >= 0 ? first + 1 : cases;
+
+    // The lowest failing case of each subject, so a run reports the same
+    // case however the work was split
+    std::vector<uint64_t> failed(subjects.size(), UINT64_MAX);
+    std::atomic<uint64_t> next(first);
+    std::atomic<uint64_t> generations(0);
+    std::mutex lock;
+    int workers = jobs > 0 ? jobs : (int)std::thread::hardware_concurrency();
+    if (workers < 1)
+        workers = 1;
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers; w++)
+    {
+        threads.push_back(std::thread([&]()
+                                      {
+                                          for (uint64_t i; (i = next++) < end;)
+                                          {
+                                              Case c = makeCase(seed, i);
+                                              Trace t = runReference(c);
+                                              generations += t.boards.size();
+                                              for (size_t s = 0; s < subjects.size(); s++)
+                                              {
+                                                  if (i > failed[s] || !diverges(c, *subjects[s], t, nullptr))
+                                                      continue;
+                                                  std::lock_guard<std::mutex> guard(lock);
+                                                  if (i < failed[s])
+                                                      failed[s] = i;
+                                              }
+                                          }
+                                      }));
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    int failures = 0;
+    for (size_t s = 0; s < subjects.size(); s++)
+    {
+        if (failed[s] == UINT64_MAX)
+        {
+            printf("%-18s ok\n", subjects[s]->name);
+            continue;
+        }
+        failures++;
+        Case c = makeCase(seed, failed[s]);
+        Divergence d;
+        diverges(c, *subjects[s], &d);
+        printf("%-18s FAILS case %llu (--seed %llu --case %llu): %dx%d, generation %u: %s\n", subjects[s]->name,
+               (unsigned long long)failed[s], (unsigned long long)seed, (unsigned long long)failed[s], c.width,
+               c.height, d.generation, d.what.c_str());
+        printRepro(shrink(c, *subjects[s]), *subjects[s]);
+    }
+    fprintf(stderr, "%llu cases, %llu generations each subject, in %.1f s on %d threads\n",
+            (unsigned long long)(end - first), (unsigned long long)generations.load(), seconds, workers);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,307 @@
+// Runs a LifeViewer over loopback with a few WebSocket viewers and checks
+// every frame they decode against the board that was sent.
+//
+//   lifeview [--size 32x8] [--frames 2000] [--viewers 1,2,4,8] [--slow 0] [--seed 1] [--port 47100]
+//
+// --slow makes the last viewer sleep that many ms per message, so it has to
+// be skipped and resynchronised with keyframes while the others keep up.
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <mutex>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "life.h"
+#include "LifeViewer.h"
+
+struct ViewerResult
+{
+    bool connected;
+    uint32_t keyframes;
+    uint32_t deltas;
+    uint32_t mismatches;
+    uint32_t lastFrame;
+};
+
+static std::mutex hashLock;
+static std::vector<uint64_t> frameHashes;
+
+static uint64_t hashBytes(const uint8_t *p, size_t n)
+{
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ p[i]) * 1099511628211ULL;
+    return h;
+}
+
+static bool parsePair(const char *s, int &a, int &b)
+{
+    return sscanf(s, "%dx%d", &a, &b) == 2 && a > 0 && b > 0;
+}
+
+static bool readAll(int sock, uint8_t *p, size_t n)
+{
+    while (n)
+    {
+        ssize_t r = recv(sock, p, n, 0);
+        if (r <= 0)
+            return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+static bool readVarint(const uint8_t *&p, const uint8_t *end, uint32_t &v)
+{
+    v = 0;
+    for (int shift = 0; p < end && shift < 35; shift += 7)
+    {
+        v |= (uint32_t)(*p & 0x7F) << shift;
+        if (!(*p++ & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static bool decodeRuns(const uint8_t *p, const uint8_t *end, std::vector<uint8_t> &cells, bool xorInto)
+{
+    size_t i = 0;
+    while (i < cells.size())
+    {
+        uint32_t zeros, literal;
+        if (!readVarint(p, end, zeros) || !readVarint(p, end, literal))
+            return false;
+        if (zeros > cells.size() - i || literal > cells.size() - i - zeros || literal > (size_t)(end - p))
+            return false;
+        if (!xorInto)
+            memset(&cells[i], 0, zeros);
+        i += zeros;
+        for (; literal; literal--, i++)
+            cells[i] = xorInto ? cells[i] ^ *p++ : *p++;
+    }
+    return p == end;
+}
+
+static void runViewer(int port, int width, int height, int delayMs, ViewerResult &result)
+{
+    result = ViewerResult();
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(sock);
+        return;
+    }
+
+    // The sample key and its answer from RFC 6455
+    const char request[] = "GET / HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+                           "Connection: Upgrade\r\nsec-websocket-key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                           "Sec-WebSocket-Version: 13\r\n\r\n";
+    send(sock, request, sizeof(request) - 1, 0);
+    std::string response;
+    char c;
+    while (response.find("\r\n\r\n") == std::string::npos && recv(sock, &c, 1, 0) == 1)
+        response += c;
+    if (response.compare(0, 12, "HTTP/1.1 101") ||
+        response.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == std::string::npos)
+    {
+        fprintf(stderr, "bad handshake: %s\n", response.c_str());
+        close(sock);
+        return;
+    }
+    result.connected = true;
+
+    size_t rowBytes = (width + 63) / 64 * 8;
+    std::vector<uint8_t> cells(rowBytes * height);
+    std::vector<uint8_t> payload;
+    bool synced = false;
+    for (;;)
+    {
+        uint8_t header[10];
+        if (!readAll(sock, header, 2))
+            break;
+        uint64_t len = header[1] & 0x7F;
+        if (header[0] != 0x82 || (header[1] & 0x80))
+        {
+            result.mismatches++;
+            break;
+        }
+        if (len >= 126)
+        {
+            int extra = len == 126 ? 2 : 8;
+            if (!readAll(sock, header + 2, extra))
+                break;
+            len = 0;
+            for (int i = 0; i < extra; i++)
+                len = len << 8 | header[2 + i];
+        }
+        payload.resize(len);
+        if (!readAll(sock, payload.data(), len))
+            break;
+        if (delayMs)
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+
+        const uint8_t *p = payload.data(), *end = p + len;
+        uint32_t frame;
+        bool ok;
+        if (len >= 9 && p[0] == 'K')
+        {
+            ok = (p[1] | p[2] << 8) == width && (p[3] | p[4] << 8) == height;
+            memcpy(&frame, p + 5, 4);
+            ok = ok && decodeRuns(p + 9, end, cells, false);
+            result.keyframes++;
+        }
+        else if (len >= 5 && p[0] == 'D')
+        {
+            memcpy(&frame, p + 1, 4);
+            // A delta only makes sense on top of the frame just before it
+            ok = synced && frame == result.lastFrame + 1 && decodeRuns(p + 5, end, cells, true);
+            result.deltas++;
+        }
+        else
+        {
+            result.mismatches++;
+            break;
+        }
+
+        if (ok)
+        {
+            std::lock_guard<std::mutex> hold(hashLock);
+            ok = frame < frameHashes.size() && frameHashes[frame] == hashBytes(cells.data(), cells.size());
+        }
+        if (!ok)
+            result.mismatches++;
+        synced = ok;
+        result.lastFrame = frame;
+    }
+
+    // Masked close, as a browser would send
+    const uint8_t closing[] = {0x88, 0x80, 0x12, 0x34, 0x56, 0x78};
+    send(sock, closing, sizeof(closing), MSG_NOSIGNAL);
+    close(sock);
+}
+
+int main(int argc, char **argv)
+{
+    int width = 32, height = 8;
+    int frames = 2000;
+    int slowMs = 0;
+    uint32_t seed = 1;
+    int port = 47100;
+    std::vector<int> counts = {1, 2, 4, 8};
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--size") && parsePair(argv[i + 1], width, height))
+            continue;
+        if (!strcmp(argv[i], "--frames"))
+            frames = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--viewers"))
+        {
+            counts.clear();
+            for (char *s = argv[i + 1]; *s;)
+            {
+                int n = strtol(s, &s, 10);
+                if (n < 1 || n > LifeViewer::MAX_VIEWERS)
+                {
+                    fprintf(stderr, "viewers must be 1 to %d\n", LifeViewer::MAX_VIEWERS);
+                    return 2;
+                }
+                counts.push_back(n);
+                if (*s == ',')
+                    s++;
+            }
+        }
+        else if (!strcmp(argv[i], "--slow"))
+            slowMs = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--seed"))
+            seed = strtoul(argv[i + 1], nullptr, 0);
+        else if (!strcmp(argv[i], "--port"))
+            port = atoi(argv[i + 1]);
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    printf("viewers  frames/s  bytes/frame  sent  skipped  keyframes  mismatches\n");
+    int bad = 0;
+    for (size_t round = 0; round < counts.size(); round++)
+    {
+        int count = counts[round];
+        uint16_t roundPort = port + round;
+        LifeViewer server(roundPort, width, height, count);
+        if (!server.begin())
+        {
+            fprintf(stderr, "cannot listen on %d\n", roundPort);
+            return 1;
+        }
+
+        std::vector<ViewerResult> results(count);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < count; i++)
+        {
+            int delayMs = slowMs && i == count - 1 && count > 1 ? slowMs : 0;
+            threads.emplace_back(runViewer, roundPort, width, height, delayMs, std::ref(results[i]));
+        }
+        while (server.getViewerCount() < count)
+            server.service();
+
+        GameOfLife life(width, height);
+        life.randomize(seed);
+        {
+            std::lock_guard<std::mutex> hold(hashLock);
+            frameHashes.assign(frames, 0);
+        }
+        size_t boardBytes = (size_t)life.getWordsPerRow() * height * sizeof(uint64_t);
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++)
+        {
+            // Rows are contiguous, the layout the compositor hands over too
+            const uint64_t *rows = life.getRow(0);
+            {
+                std::lock_guard<std::mutex> hold(hashLock);
+                frameHashes[f] = hashBytes((const uint8_t *)rows, boardBytes);
+            }
+            server.broadcast(rows, f);
+            server.service();
+            // Soups settle; a fresh one keeps the deltas busy
+            life.computeNextGeneration();
+            if (life.isGameFinished())
+                life.randomize(seed + f);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Let backed up sends finish, then hang up on everyone
+        auto drain = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - drain < std::chrono::milliseconds(200 + 4 * slowMs))
+            server.service();
+        server.end();
+        for (auto &t : threads)
+            t.join();
+
+        uint32_t keyframes = 0, mismatches = 0;
+        for (const ViewerResult &r : results)
+        {
+            keyframes += r.keyframes;
+            mismatches += r.mismatches + !r.connected;
+        }
+        bad += mismatches;
+        printf("%7d  %8.0f  %11.1f  %4u  %7u  %9u  %10u\n", count, frames / seconds,
+               server.getFramesSent() ? (double)server.getBytesSent() / server.getFramesSent() : 0.0,
+               server.getFramesSent(), server.getFramesSkipped(), keyframes, mismatches);
+    }
+    return bad ? 1 : 0;
+}
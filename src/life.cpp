@@ -1,52 +1,415 @@
-
 #include "life.h"
+#include "LifePatterns.h"
+#include "LifeTrace.h"
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#ifdef ESP32
+#include <esp_heap_caps.h>
+#endif
+
+// Cells of the word starting at column x that lie on a board `width` wide
+static inline uint64_t extractMask(int x, int width)
+{
+    uint64_t mask = ~(uint64_t)0;
+    if (x < 0)
+        mask = x <= -64 ? 0 : mask << -x;
+    if (x + 64 > width)
+        mask &= width - x <= 0 ? 0 : ~(uint64_t)0 >> (64 - (width - x));
+    return mask;
+}
+
+// 33^e modulo the width of unsigned long: a cell's weight in the djb2 hash
+static unsigned long power33(unsigned long e)
+{
+    unsigned long result = 1, base = 33;
+    for (; e; e >>= 1)
+    {
+        if (e & 1)
+            result *= base;
+        base *= base;
+    }
+    return result;
+}
+
+// Board memory comes from lifeAlloc(): the heap, or the fixed arena in a
+// heap-free build, where running out is a configuration error like a failed new[]
+static uint64_t *allocWords(size_t n)
+{
+    uint64_t *p = (uint64_t *)lifeAlloc(n * sizeof(uint64_t));
+    if (!p)
+        abort();
+    memset(p, 0, n * sizeof(uint64_t));
+    return p;
+}
+
+// Temporal blocking for stepN(): tiles of STEP_TILE_WORDS x STEP_TILE_ROWS
+// are advanced up to STEP_DEPTH generations per visit, inside a halo that
+// shrinks by one cell per generation. The halo is STEP_DEPTH rows deep and
+// one word wide, so STEP_DEPTH must stay below 64. The two working tiles
+// are sized to STEP_SCRATCH_BUDGET: internal SRAM on the ESP32, and on a
+// host a 256 KB L2, the smallest in common use, with room for the rows
+// being copied in and out (32 x 256 tiles: 162 KB). The halo is work done
+// twice, about 12% here.
+#ifdef ESP32
+static const int STEP_TILE_WORDS = 4;
+static const int STEP_TILE_ROWS = 64;
+static const int STEP_DEPTH = 8;
+static const size_t STEP_SCRATCH_BUDGET = 32 * 1024;
+#else
+static const int STEP_TILE_WORDS = 32;
+static const int STEP_TILE_ROWS = 256;
+static const int STEP_DEPTH = 16;
+static const size_t STEP_SCRATCH_BUDGET = 192 * 1024;
+#endif
+// A halo word and a zero guard word on each side
+static const int SCRATCH_WORDS = STEP_TILE_WORDS + 4;
+static const int SCRATCH_ROWS = STEP_TILE_ROWS + 2 * STEP_DEPTH;
+static_assert(2 * SCRATCH_WORDS * SCRATCH_ROWS * sizeof(uint64_t) <= STEP_SCRATCH_BUDGET,
+              "stepN()'s working tiles outgrow their cache budget");
+
 GameOfLife::GameOfLife(int w, int h, bool wrap, unsigned int maxGen)
-    : width(w), height(h), wrapAround(wrap),
-      generationCount(0), maxGenerations(maxGen)
+    : width(w), height(h), wrapAround(wrap), historySize(0), historyHead(0),
+      generationCount(0), maxGenerations(maxGen), finalPeriod(0), seed(0),
+      scratch(nullptr), nextValid(false), neighbourCounts(nullptr),
+      incrementalHash(0), countsValid(false), changesValid(false), statsValid(false), boxValid(false),
+      statsTracked(false)
 {
-    board = new bool[width * height]();
-    nextBoard = new bool[width * height]();
+    wordsPerRow = (width + 63) / 64;
+    lastWordMask = (width % 64) ? ((uint64_t)1 << (width % 64)) - 1 : ~(uint64_t)0;
+    board = allocWords(wordsPerRow * height);
+    nextBoard = allocWords(wordsPerRow * height);
+    rowBuffers = allocWords(3 * (wordsPerRow + 2));
+    tilesWide = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesHigh = (height + TILE_SIZE - 1) / TILE_SIZE;
+    tileActivity.assign(tilesWide * tilesHigh, 0);
+    nextTileActivity.assign(tilesWide * tilesHigh, 0);
+    resetStats(stats, tileActivity);
+    setEngine(ENGINE_AUTO);
     srand(time(NULL));
 }
 
 GameOfLife::~GameOfLife()
 {
-    delete[] board;
-    delete[] nextBoard;
+    // Newest first, so the arena can take them back
+#if LIFE_STATIC_MEMORY
+    lifeFree(scratch);
+#elif defined(ESP32)
+    heap_caps_free(scratch);
+#else
+    delete[] scratch;
+#endif
+    changes = LifeVector<int>();
+    pendingChanges = LifeVector<int>();
+    lifeFree(neighbourCounts);
+    nextTileActivity = LifeVector<uint8_t>();
+    tileActivity = LifeVector<uint8_t>();
+    lifeFree(rowBuffers);
+    lifeFree(nextBoard);
+    lifeFree(board);
+}
+
+bool GameOfLife::setEngine(LifeEngine e)
+{
+    LifeKernelType type;
+    switch (e)
+    {
+    case ENGINE_REFERENCE:
+    case ENGINE_PORTABLE:
+        type = KERNEL_PORTABLE;
+        break;
+    case ENGINE_SSE2:
+        type = KERNEL_SSE2;
+        break;
+    case ENGINE_AVX2:
+        type = KERNEL_AVX2;
+        break;
+    default:
+        // ENGINE_INCREMENTAL works per cell and never calls the kernel
+        type = lifeBestKernel();
+        break;
+    }
+    if (!lifeKernelSupported(type))
+        return false;
+
+    if (e == ENGINE_INCREMENTAL && !neighbourCounts)
+    {
+        neighbourCounts = (uint8_t *)lifeAlloc(width * height);
+        if (!neighbourCounts)
+            return false;
+#if LIFE_STATIC_MEMORY
+        // Every cell flipping at once is the most a list ever holds
+        changes.reserve(width * height);
+        pendingChanges.reserve(width * height);
+#endif
+    }
+    engine = e;
+    rowKernel = lifeRowKernel(type);
+    boardEdited();
+    return true;
 }
 
 void GameOfLife::randomize()
 {
+    seed = 0; // Not reproducible
     for (int i = 0; i < width * height; i++)
     {
-        board[i] = (rand() % 2) == 1;
+        setCell(i % width, i / width, (rand() % 2) == 1);
     }
 }
 
-int GameOfLife::getIndex(int x, int y) const
+void GameOfLife::randomize(uint32_t s)
 {
-    if (wrapAround)
+    // xorshift32, so a screened seed reproduces the same soup anywhere
+    seed = s;
+    uint32_t x = s ? s : 0x9E3779B9;
+    for (int i = 0; i < width * height; i++)
     {
-        x = (x + width) % width;
-        y = (y + height) % height;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        setCell(i % width, i / width, (x >> 31) != 0);
+    }
+}
+
+int GameOfLife::getPopulation() const
+{
+    if (statsValid)
+        return stats.population;
+    int count = 0;
+    for (int i = 0; i < wordsPerRow * height; i++)
+    {
+        count += __builtin_popcountll(board[i]);
+    }
+    return count;
+}
+
+const LifeStats &GameOfLife::getStats()
+{
+    if (!statsValid)
+        countStats();
+    else if (!boxValid)
+        shrinkBox();
+    return stats;
+}
+
+const uint8_t *GameOfLife::getTileActivity()
+{
+    getStats();
+    return tileActivity.data();
+}
+
+void GameOfLife::resetStats(LifeStats &s, LifeVector<uint8_t> &activity) const
+{
+    s.generation = generationCount;
+    s.population = s.births = s.deaths = s.activeTiles = 0;
+    s.minX = width;
+    s.minY = height;
+    s.maxX = s.maxY = -1;
+    memset(activity.data(), 0, activity.size());
+}
+
+// Cells set in each byte of v, one count per byte
+static inline uint64_t byteCounts(uint64_t v)
+{
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    return (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+}
+
+// Births, deaths, tile activity and the box from a row's packed words
+// before and after a step, starting at word w0. Bit counts are done a byte
+// at a time, as neither target has a popcount instruction by default, and
+// the population follows from births and deaths (commitStats()).
+void GameOfLife::addRowStats(int y, int w0, const uint64_t *cur, const uint64_t *next, int words,
+                             LifeStats &s, uint8_t *activity) const
+{
+    // Locals, so stores to the activity bytes do not make the compiler
+    // reload them every word
+    int births = 0, changed = 0, active = 0;
+    int minX = s.minX, maxX = s.maxX;
+    bool any = false;
+    uint8_t *tiles = activity + (y / TILE_SIZE) * tilesWide + w0 * 64 / TILE_SIZE;
+    for (int j = 0; j < words; j++, tiles += 64 / TILE_SIZE)
+    {
+        uint64_t now = next[j];
+        uint64_t diff = cur[j] ^ now;
+        int x0 = (w0 + j) * 64;
+        if (now)
+        {
+            any = true;
+            if (x0 < minX && x0 + __builtin_ctzll(now) < minX)
+                minX = x0 + __builtin_ctzll(now);
+            if (x0 + 63 > maxX && x0 + 63 - __builtin_clzll(now) > maxX)
+                maxX = x0 + 63 - __builtin_clzll(now);
+        }
+        if (!diff)
+            continue;
+
+        // Changed cells per byte, each byte being one tile's row
+        uint64_t born = byteCounts(diff & now);
+        uint64_t c = born + byteCounts(diff & ~now);
+        births += (int)((born * 0x0101010101010101ULL) >> 56);
+        changed += (int)((c * 0x0101010101010101ULL) >> 56);
+        if (x0 / TILE_SIZE + 8 <= tilesWide)
+        {
+            // All eight tiles at once: a byte never exceeds 64, so neither
+            // the sum nor the +0x7F test carries between bytes (bytes in
+            // memory order, as on the ESP32 and x86)
+            uint64_t t;
+            memcpy(&t, tiles, 8);
+            uint64_t fresh = (c + 0x7F7F7F7F7F7F7F7FULL) & ~(t + 0x7F7F7F7F7F7F7F7FULL) & 0x8080808080808080ULL;
+            active += (int)(((fresh >> 7) * 0x0101010101010101ULL) >> 56);
+            t += c;
+            memcpy(tiles, &t, 8);
+        }
+        else
+        {
+            for (int b = 0; x0 / TILE_SIZE + b < tilesWide; b++)
+            {
+                uint8_t n = (c >> (8 * b)) & 0xFF;
+                if (n && tiles[b] == 0)
+                    active++;
+                tiles[b] += n;
+            }
+        }
+    }
+
+    s.births += births;
+    s.deaths += changed - births;
+    s.activeTiles += active;
+    s.minX = minX;
+    s.maxX = maxX;
+    if (any)
+    {
+        if (y < s.minY)
+            s.minY = y;
+        if (y > s.maxY)
+            s.maxY = y;
+    }
+}
+
+// Called once nextBoard, and nextStats with it, have become board
+void GameOfLife::commitStats()
+{
+    int population = stats.population + nextStats.births - nextStats.deaths;
+    bool counted = statsValid;
+    stats = nextStats;
+    stats.generation = generationCount;
+    tileActivity.swap(nextTileActivity);
+    statsValid = false;
+    // Only after an edit, when the old population was not known
+    stats.population = counted ? population : getPopulation();
+    statsValid = boxValid = true;
+}
+
+// After an edit: nothing is known to have changed, so no births or activity
+void GameOfLife::countStats()
+{
+    resetStats(stats, tileActivity);
+    statsValid = false;
+    stats.population = getPopulation();
+    for (int y = 0; y < height; y++)
+    {
+        const uint64_t *row = board + y * wordsPerRow;
+        addRowStats(y, 0, row, row, wordsPerRow, stats, tileActivity.data());
     }
-    return y * width + x;
+    statsValid = boxValid = true;
+}
+
+// Every word in rows y0-y1 and words w0-w1 ORed together
+uint64_t GameOfLife::cellsIn(int y0, int y1, int w0, int w1) const
+{
+    uint64_t bits = 0;
+    for (int y = y0; y <= y1; y++)
+    {
+        for (int w = w0; w <= w1; w++)
+            bits |= board[y * wordsPerRow + w];
+    }
+    return bits;
+}
+
+// Live cells only ever lie inside the old box, so it is searched inwards
+// from each side until a cell turns up
+void GameOfLife::shrinkBox()
+{
+    boxValid = true;
+    if (stats.population == 0)
+    {
+        stats.minX = width;
+        stats.minY = height;
+        stats.maxX = stats.maxY = -1;
+        return;
+    }
+    int w0 = stats.minX / 64, w1 = stats.maxX / 64;
+    while (!cellsIn(stats.minY, stats.minY, w0, w1))
+        stats.minY++;
+    while (!cellsIn(stats.maxY, stats.maxY, w0, w1))
+        stats.maxY--;
+    while (!cellsIn(stats.minY, stats.maxY, w0, w0))
+        w0++;
+    while (!cellsIn(stats.minY, stats.maxY, w1, w1))
+        w1--;
+    stats.minX = w0 * 64 + __builtin_ctzll(cellsIn(stats.minY, stats.maxY, w0, w0));
+    stats.maxX = w1 * 64 + 63 - __builtin_clzll(cellsIn(stats.minY, stats.maxY, w1, w1));
 }
 
 bool GameOfLife::getCell(int x, int y) const
 {
     if (!wrapAround && (x < 0 || x >= width || y < 0 || y >= height))
         return false;
-    return board[getIndex(x, y)];
+    if (wrapAround)
+    {
+        x = (x + width) % width;
+        y = (y + height) % height;
+    }
+    return (board[y * wordsPerRow + x / 64] >> (x % 64)) & 1;
 }
 
 void GameOfLife::setCell(int x, int y, bool state)
 {
     if (x >= 0 && x < width && y >= 0 && y < height)
-        board[getIndex(x, y)] = state;
+    {
+        uint64_t &word = board[y * wordsPerRow + x / 64];
+        uint64_t bit = (uint64_t)1 << (x % 64);
+        word = state ? (word | bit) : (word & ~bit);
+        cellsEdited();
+    }
+}
+
+void GameOfLife::setRow(int y, const uint64_t *words)
+{
+    if (y < 0 || y >= height)
+        return;
+    uint64_t *row = board + y * wordsPerRow;
+    memcpy(row, words, wordsPerRow * sizeof(uint64_t));
+    row[wordsPerRow - 1] &= lastWordMask;
+    cellsEdited();
+}
+
+void GameOfLife::restoreState(unsigned int generations, unsigned int maxGen, unsigned int period,
+                              uint32_t s, const unsigned long *history, int count)
+{
+    generationCount = generations;
+    maxGenerations = maxGen;
+    finalPeriod = period;
+    seed = s;
+    clearHistory();
+    // Only the newest HISTORY_SIZE count
+    for (int i = count > HISTORY_SIZE ? count - HISTORY_SIZE : 0; i < count; i++)
+    {
+        boardHistory[historyHead] = history[i];
+        historyHead = (historyHead + 1) % HISTORY_SIZE;
+        historySize++;
+    }
+}
+
+int GameOfLife::getHistory(unsigned long *out) const
+{
+    for (int i = 0; i < historySize; i++)
+        out[i] = boardHistory[(historyHead - historySize + i + HISTORY_SIZE) % HISTORY_SIZE];
+    return historySize;
 }
 
 int GameOfLife::countNeighbors(int x, int y) const
@@ -65,8 +428,9 @@ int GameOfLife::countNeighbors(int x, int y) const
     return count;
 }
 
-void GameOfLife::computeNextGeneration()
+void GameOfLife::computeNextReference()
 {
+    memset(nextBoard, 0, wordsPerRow * height * sizeof(uint64_t));
     for (int y = 0; y < height; y++)
     {
         for (int x = 0; x < width; x++)
@@ -74,48 +438,485 @@ void GameOfLife::computeNextGeneration()
             int neighbors = countNeighbors(x, y);
             bool currentCell = getCell(x, y);
 
-            nextBoard[getIndex(x, y)] =
-                (currentCell && (neighbors == 2 || neighbors == 3)) ||
-                (!currentCell && neighbors == 3);
+            if ((currentCell && (neighbors == 2 || neighbors == 3)) ||
+                (!currentCell && neighbors == 3))
+                nextBoard[y * wordsPerRow + x / 64] |= (uint64_t)1 << (x % 64);
+        }
+        if (statsTracked)
+            addRowStats(y, 0, board + y * wordsPerRow, nextBoard + y * wordsPerRow, wordsPerRow, nextStats,
+                        nextTileActivity.data());
+    }
+}
+
+// Row y (wrapped, or blank off the board) with a guard word either side
+// holding the cells just beyond its ends
+void GameOfLife::fillGuardedRow(int y, uint64_t *dst) const
+{
+    if (wrapAround)
+        y = (y + height) % height;
+    else if (y < 0 || y >= height)
+    {
+        memset(dst, 0, (wordsPerRow + 2) * sizeof(uint64_t));
+        return;
+    }
+
+    const uint64_t *row = board + y * wordsPerRow;
+    memcpy(dst + 1, row, wordsPerRow * sizeof(uint64_t));
+    dst[0] = 0;
+    dst[wordsPerRow + 1] = 0;
+    if (wrapAround)
+    {
+        uint64_t first = row[0] & 1;
+        uint64_t last = (row[(width - 1) / 64] >> ((width - 1) % 64)) & 1;
+        dst[0] = last << 63;
+        // The cell east of the last column sits in the unused bits when the
+        // width is not a multiple of 64
+        if (width % 64)
+            dst[wordsPerRow] |= first << (width % 64);
+        else
+            dst[wordsPerRow + 1] = first;
+    }
+}
+
+void GameOfLife::computeNextPacked()
+{
+    const int stride = wordsPerRow + 2;
+    uint64_t *up = rowBuffers;
+    uint64_t *mid = rowBuffers + stride;
+    uint64_t *down = rowBuffers + 2 * stride;
+
+    fillGuardedRow(-1, up);
+    fillGuardedRow(0, mid);
+    for (int y = 0; y < height; y++)
+    {
+        fillGuardedRow(y + 1, down);
+        uint64_t *out = nextBoard + y * wordsPerRow;
+        rowKernel(up + 1, mid + 1, down + 1, out, wordsPerRow);
+        out[wordsPerRow - 1] &= lastWordMask;
+        // Not mid: on a wrapped board its last word carries the cell east of the edge
+        if (statsTracked)
+            addRowStats(y, 0, board + y * wordsPerRow, out, wordsPerRow, nextStats, nextTileActivity.data());
+
+        uint64_t *temp = up;
+        up = mid;
+        mid = down;
+        down = temp;
+    }
+}
+
+// The neighbours of cell i, one entry per direction: on a wrapped board
+// narrower than three cells the same cell can appear more than once
+int GameOfLife::neighbourCells(int i, int *out) const
+{
+    int x = i % width, y = i / width;
+    int n = 0;
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            if (dx == 0 && dy == 0)
+                continue;
+            int nx = x + dx, ny = y + dy;
+            if (wrapAround)
+            {
+                nx = (nx + width) % width;
+                ny = (ny + height) % height;
+            }
+            else if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+                continue;
+            out[n++] = ny * width + nx;
+        }
+    }
+    return n;
+}
+
+void GameOfLife::rebuildCounts()
+{
+    int around[8];
+    memset(neighbourCounts, 0, width * height);
+    for (int y = 0; y < height; y++)
+    {
+        for (int w = 0; w < wordsPerRow; w++)
+        {
+            for (uint64_t bits = board[y * wordsPerRow + w]; bits; bits &= bits - 1)
+            {
+                int n = neighbourCells(y * width + w * 64 + __builtin_ctzll(bits), around);
+                for (int j = 0; j < n; j++)
+                    neighbourCounts[around[j]]++;
+            }
         }
     }
+    incrementalHash = fullBoardHash();
+    countsValid = true;
+}
+
+// Apply the rule to cell i, flipping it in nextBoard if it changes
+void GameOfLife::evaluateCell(int i)
+{
+    int x = i % width, y = i / width;
+    int w = y * wordsPerRow + x / 64;
+    uint64_t bit = (uint64_t)1 << (x % 64);
+    bool alive = (board[w] & bit) != 0;
+    int neighbors = neighbourCounts[i];
+    bool next = neighbors == 3 || (alive && neighbors == 2);
+
+    // Neighbouring changes reach the same cell several times; flip it once
+    if (next != alive && ((nextBoard[w] & bit) != 0) == alive)
+    {
+        nextBoard[w] ^= bit;
+        pendingChanges.push_back(i);
+    }
+}
+
+void GameOfLife::computeNextIncremental()
+{
+    pendingChanges.clear();
+    if (!countsValid)
+    {
+        // After an edit, start again from a pass over every cell
+        rebuildCounts();
+        memcpy(nextBoard, board, wordsPerRow * height * sizeof(uint64_t));
+        for (int i = 0; i < width * height; i++)
+            evaluateCell(i);
+        return;
+    }
 
-    bool *temp = board;
+    // nextBoard holds the previous generation; bring it level with board
+    for (size_t c = 0; c < changes.size(); c++)
+    {
+        int x = changes[c] % width, y = changes[c] / width;
+        nextBoard[y * wordsPerRow + x / 64] ^= (uint64_t)1 << (x % 64);
+    }
+
+    // Only cells next to last generation's changes can change now
+    int around[8];
+    for (size_t c = 0; c < changes.size(); c++)
+    {
+        evaluateCell(changes[c]);
+        int n = neighbourCells(changes[c], around);
+        for (int j = 0; j < n; j++)
+            evaluateCell(around[j]);
+    }
+}
+
+// Called once nextBoard has become board
+void GameOfLife::commitChanges()
+{
+    int around[8];
+    unsigned long cells = (unsigned long)width * height;
+    // The statistics follow from the flips too, once they have been counted
+    LifeStats before = stats;
+    if (statsTracked)
+        resetStats(stats, tileActivity);
+    if (statsTracked && statsValid)
+    {
+        stats.population = before.population;
+        stats.minX = before.minX;
+        stats.minY = before.minY;
+        stats.maxX = before.maxX;
+        stats.maxY = before.maxY;
+    }
+    for (size_t c = 0; c < pendingChanges.size(); c++)
+    {
+        int i = pendingChanges[c];
+        int x = i % width, y = i / width;
+        bool alive = (board[y * wordsPerRow + x / 64] >> (x % 64)) & 1;
+
+        if (statsTracked)
+        {
+            uint8_t &tile = tileActivity[(y / TILE_SIZE) * tilesWide + x / TILE_SIZE];
+            if (tile++ == 0)
+                stats.activeTiles++;
+            if (alive)
+            {
+                stats.births++;
+                if (x < stats.minX)
+                    stats.minX = x;
+                if (x > stats.maxX)
+                    stats.maxX = x;
+                if (y < stats.minY)
+                    stats.minY = y;
+                if (y > stats.maxY)
+                    stats.maxY = y;
+            }
+            else
+            {
+                stats.deaths++;
+                if (x == stats.minX || x == stats.maxX || y == stats.minY || y == stats.maxY)
+                    boxValid = false;
+            }
+        }
+
+        int n = neighbourCells(i, around);
+        for (int j = 0; j < n; j++)
+            neighbourCounts[around[j]] += alive ? 1 : -1;
+
+        // The hash is linear in the cells, so a flip adds or removes its weight
+        unsigned long weight = power33(cells - 1 - i);
+        incrementalHash = alive ? incrementalHash + weight : incrementalHash - weight;
+    }
+    changes.swap(pendingChanges);
+    changesValid = true;
+
+    if (!statsTracked)
+        statsValid = false;
+    else if (statsValid)
+    {
+        stats.generation = generationCount;
+        stats.population += stats.births - stats.deaths;
+    }
+    else
+    {
+        // The first step after an edit: the changes are known, but not
+        // the rest of the board
+        stats.generation = generationCount;
+        stats.population = getPopulation();
+        stats.minX = stats.minY = 0;
+        stats.maxX = width - 1;
+        stats.maxY = height - 1;
+        statsValid = true;
+        boxValid = false;
+    }
+}
+
+void GameOfLife::computeNext()
+{
+    // ENGINE_INCREMENTAL takes its statistics from the change list instead
+    if (engine != ENGINE_INCREMENTAL && statsTracked)
+        resetStats(nextStats, nextTileActivity);
+    if (engine == ENGINE_REFERENCE)
+        computeNextReference();
+    else if (engine == ENGINE_INCREMENTAL)
+        computeNextIncremental();
+    else
+        computeNextPacked();
+}
+
+void GameOfLife::computeNextGeneration()
+{
+    TRACE_SCOPE(TRACE_STEP, generationCount);
+    // isGameFinished() may already have worked it out
+    if (!nextValid)
+        computeNext();
+
+    uint64_t *temp = board;
     board = nextBoard;
     nextBoard = temp;
+    nextValid = false;
     generationCount++;
+    if (engine == ENGINE_INCREMENTAL)
+        commitChanges();
+    else if (statsTracked)
+        commitStats();
+    else
+        statsValid = false;
 }
 
-bool GameOfLife::isGameFinished()
+void GameOfLife::stepN(unsigned int k)
 {
-    // Check generation limit first
-    if (generationCount >= maxGenerations)
+    TRACE_SCOPE(TRACE_STEP_N, k);
+    // The per-cell engines keep their own semantics and state; they step one
+    // generation at a time
+    if (engine == ENGINE_REFERENCE || engine == ENGINE_INCREMENTAL)
     {
-        return true;
+        for (; k > 0; k--)
+            computeNextGeneration();
+        return;
     }
-    // First check if the board is static (no changes)
-    bool isStatic = true;
-    for (int y = 0; y < height; y++)
+    if (!scratch)
     {
-        for (int x = 0; x < width; x++)
+        size_t bytes = 2 * SCRATCH_WORDS * SCRATCH_ROWS * sizeof(uint64_t);
+#if LIFE_STATIC_MEMORY
+        scratch = (uint64_t *)lifeAlloc(bytes);
+#elif defined(ESP32)
+        // Internal SRAM, even when the boards themselves live in PSRAM
+        scratch = (uint64_t *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#endif
+#if LIFE_STATIC_MEMORY || defined(ESP32)
+        if (!scratch)
         {
-            int neighbors = countNeighbors(x, y);
-            bool currentCell = getCell(x, y);
-            bool nextState = (currentCell && (neighbors == 2 || neighbors == 3)) ||
-                             (!currentCell && neighbors == 3);
+            for (; k > 0; k--)
+                computeNextGeneration();
+            boardEdited();
+            return;
+        }
+#else
+        scratch = new uint64_t[bytes / sizeof(uint64_t)];
+#endif
+    }
+
+    while (k > 0)
+    {
+        int depth = k < (unsigned int)STEP_DEPTH ? k : STEP_DEPTH;
+        if (statsTracked)
+            resetStats(nextStats, nextTileActivity);
+        for (int y0 = 0; y0 < height; y0 += STEP_TILE_ROWS)
+        {
+            for (int wx = 0; wx < wordsPerRow; wx += STEP_TILE_WORDS)
+            {
+                int tileWords = wordsPerRow - wx < STEP_TILE_WORDS ? wordsPerRow - wx : STEP_TILE_WORDS;
+                int tileRows = height - y0 < STEP_TILE_ROWS ? height - y0 : STEP_TILE_ROWS;
+                stepTile(wx, y0, tileWords, tileRows, depth);
+            }
+        }
+
+        uint64_t *temp = board;
+        board = nextBoard;
+        nextBoard = temp;
+        generationCount += depth;
+        k -= depth;
+        if (statsTracked)
+            commitStats();
+        else
+            statsValid = false;
+    }
+    boardEdited();
+}
+
+// 64 cells of row y starting at column x, which may lie off either end
+uint64_t GameOfLife::extractWord(int y, int x) const
+{
+    const uint64_t *row = board + y * wordsPerRow;
+    if (x >= 0 && x + 64 <= width)
+    {
+        int w = x / 64, s = x % 64;
+        return s ? (row[w] >> s) | (row[w + 1] << (64 - s)) : row[w];
+    }
+    if (!wrapAround)
+    {
+        // Bits past the last column are already clear
+        if (x <= -64 || x >= wordsPerRow * 64)
+            return 0;
+        if (x < 0)
+            return row[0] << -x;
+        int w = x / 64, s = x % 64;
+        uint64_t v = row[w] >> s;
+        if (s && w + 1 < wordsPerRow)
+            v |= row[w + 1] << (64 - s);
+        return v;
+    }
+
+    // Wrapping across the edge, possibly more than once on a narrow board;
+    // a run at a time, up to the end of a word or of the row
+    uint64_t v = 0;
+    int cx = (x % width + width) % width;
+    for (int b = 0; b < 64;)
+    {
+        int n = 64 - cx % 64;
+        n = n < width - cx ? n : width - cx;
+        n = n < 64 - b ? n : 64 - b;
+        uint64_t bits = row[cx / 64] >> (cx % 64);
+        if (n < 64)
+            bits &= (1ULL << n) - 1;
+        v |= bits << b;
+        b += n;
+        cx += n;
+        if (cx == width)
+            cx = 0;
+    }
+    return v;
+}
 
-            if (nextState != currentCell)
+void GameOfLife::stepTile(int wx, int y0, int tileWords, int tileRows, int depth)
+{
+    // Scratch rows: guard, halo word, tile words, halo word, guard. The
+    // guards are blank, which corrupts the halo words from the outside in
+    // by one cell per generation; depth < 64 keeps the tile itself exact.
+    const int sw = tileWords + 4;
+    const int sh = tileRows + 2 * depth;
+    const int x0 = wx * 64 - 64; // Column of the first halo word
+    uint64_t *cur = scratch;
+    uint64_t *next = scratch + SCRATCH_WORDS * SCRATCH_ROWS;
+
+    for (int sy = 0; sy < sh; sy++)
+    {
+        uint64_t *dst = cur + sy * sw;
+        dst[0] = dst[sw - 1] = 0;
+        next[sy * sw] = next[sy * sw + sw - 1] = 0;
+
+        int y = y0 - depth + sy;
+        if (wrapAround)
+            y = (y % height + height) % height; // The halo can be deeper than the board
+        else if (y < 0 || y >= height)
+        {
+            // Off the board rows stay blank in both buffers
+            memset(dst, 0, sw * sizeof(uint64_t));
+            memset(next + sy * sw, 0, sw * sizeof(uint64_t));
+            continue;
+        }
+
+        // Whole words inside the board copy straight across
+        const uint64_t *row = board + y * wordsPerRow;
+        for (int j = 0; j < tileWords + 2; j++)
+        {
+            int x = x0 + 64 * j;
+            dst[1 + j] = (x >= 0 && x + 64 <= width) ? row[x / 64] : extractWord(y, x);
+        }
+    }
+
+    for (int gen = 1; gen <= depth; gen++)
+    {
+        // Each generation the valid region shrinks by one row top and bottom
+        for (int sy = gen; sy < sh - gen; sy++)
+        {
+            int y = y0 - depth + sy;
+            if (!wrapAround && (y < 0 || y >= height))
+                continue;
+            uint64_t *out = next + sy * sw + 1;
+            rowKernel(cur + (sy - 1) * sw + 1, cur + sy * sw + 1, cur + (sy + 1) * sw + 1,
+                      out, tileWords + 2);
+
+            if (!wrapAround)
             {
-                isStatic = false;
-                break;
+                // Cells off the board never come alive
+                for (int j = 0; j < tileWords + 2; j++)
+                {
+                    int x = x0 + 64 * j;
+                    if (x < 0 || x + 64 > width)
+                        out[j] &= extractMask(x, width);
+                }
             }
         }
-        if (!isStatic)
-            break;
+        uint64_t *temp = cur;
+        cur = next;
+        next = temp;
     }
 
+    for (int ty = 0; ty < tileRows; ty++)
+    {
+        uint64_t *dst = nextBoard + (y0 + ty) * wordsPerRow + wx;
+        memcpy(dst, cur + (ty + depth) * sw + 2, tileWords * sizeof(uint64_t));
+        if (wx + tileWords == wordsPerRow)
+            dst[tileWords - 1] &= lastWordMask;
+        if (statsTracked)
+            addRowStats(y0 + ty, wx, board + (y0 + ty) * wordsPerRow + wx, dst, tileWords, nextStats,
+                        nextTileActivity.data());
+    }
+}
+
+bool GameOfLife::isGameFinished()
+{
+    TRACE_SCOPE(TRACE_FINISH_CHECK);
+    // Check generation limit first
+    if (generationCount >= maxGenerations)
+    {
+        finalPeriod = 0;
+        return true;
+    }
+    // First check if the board is static (no changes). The next generation
+    // is kept for computeNextGeneration().
+    if (!nextValid)
+    {
+        computeNext();
+        nextValid = true;
+    }
+    bool isStatic = engine == ENGINE_INCREMENTAL
+                        ? pendingChanges.empty()
+                        : memcmp(board, nextBoard, wordsPerRow * height * sizeof(uint64_t)) == 0;
+
     if (isStatic)
     {
+        finalPeriod = 1;
         clearHistory();
         return true;
     }
@@ -123,128 +924,104 @@ bool GameOfLife::isGameFinished()
     // Check for oscillating patterns
     unsigned long currentHash = calculateBoardHash();
 
-    // Look for this hash in our history
-    for (unsigned long previousHash : boardHistory)
+    // Look for this hash in our history, oldest first
+    for (int i = 0; i < historySize; i++)
     {
-        if (previousHash == currentHash)
+        if (boardHistory[(historyHead - historySize + i + HISTORY_SIZE) % HISTORY_SIZE] == currentHash)
         {
+            finalPeriod = historySize - i;
             clearHistory();
             return true; // Pattern repeats
         }
     }
 
-    // Add current state to history
-    boardHistory.push_back(currentHash);
-    if (boardHistory.size() > maxHistorySize)
-    {
-        boardHistory.erase(boardHistory.begin());
-    }
+    // Add current state to history, overwriting the oldest once full
+    boardHistory[historyHead] = currentHash;
+    historyHead = (historyHead + 1) % HISTORY_SIZE;
+    if (historySize < HISTORY_SIZE)
+        historySize++;
 
     return false;
 }
 
 unsigned long GameOfLife::calculateBoardHash() const
 {
+    // ENGINE_INCREMENTAL keeps it up to date as cells flip
+    if (countsValid)
+        return incrementalHash;
+    return fullBoardHash();
+}
+
+unsigned long GameOfLife::fullBoardHash() const
+{
+    // djb2 over every cell in row order, eight cells at a time: a byte of
+    // cells adds its own polynomial in 33 to hash * 33^8
+    struct ByteHashes
+    {
+        unsigned long byte[256];
+        unsigned long pow8;
+    };
+    // Built once, on first use; a local static is safe against boards
+    // hashing on several threads at once
+    static const ByteHashes table = []()
+    {
+        ByteHashes t;
+        for (int b = 0; b < 256; b++)
+        {
+            unsigned long h = 0;
+            for (int j = 0; j < 8; j++)
+                h = h * 33 + ((b >> j) & 1);
+            t.byte[b] = h;
+        }
+        t.pow8 = 1;
+        for (int j = 0; j < 8; j++)
+            t.pow8 *= 33;
+        return t;
+    }();
+    const unsigned long *byteHash = table.byte;
+    const unsigned long pow8 = table.pow8;
+
     unsigned long hash = 5381; // Initial value (djb2 algorithm)
-    for (int i = 0; i < width * height; i++)
+    for (int y = 0; y < height; y++)
     {
-        hash = ((hash << 5) + hash) + (board[i] ? 1 : 0);
+        const uint64_t *row = board + y * wordsPerRow;
+        int x = 0;
+        for (; x + 8 <= width; x += 8)
+            hash = hash * pow8 + byteHash[(row[x / 64] >> (x % 64)) & 0xFF];
+        for (; x < width; x++)
+            hash = ((hash << 5) + hash) + ((row[x / 64] >> (x % 64)) & 1);
     }
     return hash;
 }
 
 void GameOfLife::clearHistory()
 {
-    boardHistory.clear();
+    historySize = 0;
+    historyHead = 0;
 }
 
 void GameOfLife::createGlider(int startX, int startY)
 {
-    setCell(startX + 1, startY, true);     // .#.
-    setCell(startX + 2, startY + 1, true); // ..#
-    setCell(startX, startY + 2, true);     // ###
-    setCell(startX + 1, startY + 2, true);
-    setCell(startX + 2, startY + 2, true);
+    stampGlider(*this, startX, startY);
 }
 
 void GameOfLife::createBlinker(int startX, int startY)
 {
-    setCell(startX, startY, true); // ###
-    setCell(startX + 1, startY, true);
-    setCell(startX + 2, startY, true);
+    stampBlinker(*this, startX, startY);
 }
 
 void GameOfLife::createPulsar(int startX, int startY)
 {
-    // Outer squares
-    for (int i = 0; i < 3; i++)
-    {
-        setCell(startX + 2 + i, startY, true);
-        setCell(startX + 2 + i, startY + 5, true);
-        setCell(startX + 8 + i, startY, true);
-        setCell(startX + 8 + i, startY + 5, true);
-
-        setCell(startX, startY + 2 + i, true);
-        setCell(startX + 5, startY + 2 + i, true);
-        setCell(startX + 7, startY + 2 + i, true);
-        setCell(startX + 12, startY + 2 + i, true);
-    }
+    stampPulsar(*this, startX, startY);
 }
 
 void GameOfLife::createGliderGun(int startX, int startY)
 {
-    // Left square
-    setCell(startX + 1, startY + 5, true);
-    setCell(startX + 2, startY + 5, true);
-    setCell(startX + 1, startY + 6, true);
-    setCell(startX + 2, startY + 6, true);
-
-    // Left pattern
-    setCell(startX + 11, startY + 5, true);
-    setCell(startX + 11, startY + 6, true);
-    setCell(startX + 11, startY + 7, true);
-    setCell(startX + 12, startY + 4, true);
-    setCell(startX + 12, startY + 8, true);
-    setCell(startX + 13, startY + 3, true);
-    setCell(startX + 13, startY + 9, true);
-    setCell(startX + 14, startY + 3, true);
-    setCell(startX + 14, startY + 9, true);
-    setCell(startX + 15, startY + 6, true);
-    setCell(startX + 16, startY + 4, true);
-    setCell(startX + 16, startY + 8, true);
-    setCell(startX + 17, startY + 5, true);
-    setCell(startX + 17, startY + 6, true);
-    setCell(startX + 17, startY + 7, true);
-    setCell(startX + 18, startY + 6, true);
-
-    // Right pattern
-    setCell(startX + 21, startY + 3, true);
-    setCell(startX + 21, startY + 4, true);
-    setCell(startX + 21, startY + 5, true);
-    setCell(startX + 22, startY + 3, true);
-    setCell(startX + 22, startY + 4, true);
-    setCell(startX + 22, startY + 5, true);
-    setCell(startX + 23, startY + 2, true);
-    setCell(startX + 23, startY + 6, true);
-    setCell(startX + 25, startY + 1, true);
-    setCell(startX + 25, startY + 2, true);
-    setCell(startX + 25, startY + 6, true);
-    setCell(startX + 25, startY + 7, true);
-
-    // Right square
-    setCell(startX + 35, startY + 3, true);
-    setCell(startX + 35, startY + 4, true);
-    setCell(startX + 36, startY + 3, true);
-    setCell(startX + 36, startY + 4, true);
+    stampGliderGun(*this, startX, startY);
 }
 
 void GameOfLife::clear()
 {
-    for (int y = 0; y < height; y++)
-    {
-        for (int x = 0; x < width; x++)
-        {
-            setCell(x, y, false);
-        }
-    }
+    memset(board, 0, wordsPerRow * height * sizeof(uint64_t));
+    cellsEdited();
 }
@@ -1,18 +1,83 @@
 #pragma once
+#include <limits.h>
+#include <stdint.h>
 #include <vector>
+#include "LifeArena.h"
+#include "LifeKernel.h"
+
+// How computeNextGeneration() steps the board. Every engine gives identical results.
+enum LifeEngine
+{
+    ENGINE_AUTO,      // Fastest packed kernel the CPU supports
+    ENGINE_REFERENCE, // Per-cell neighbour count
+    ENGINE_PORTABLE,  // Packed 64-bit words
+    ENGINE_SSE2,
+    ENGINE_AVX2,
+    ENGINE_INCREMENTAL // Neighbour counts updated around last generation's changes
+};
+
+// With tracking on, kept up to date from the same pass that computes each
+// generation, so reading them costs nothing (GameOfLife::getStats())
+struct LifeStats
+{
+    unsigned int generation; // The generation they describe
+    int population;
+    // Since the board before: the last generation, or stepN()'s last pass
+    int births;
+    int deaths;
+    // Smallest box holding every live cell, inclusive; minX > maxX when empty
+    int minX, minY, maxX, maxY;
+    int activeTiles; // Tiles with a change since the board before
+};
 
 class GameOfLife
 {
+public:
+    static const int HISTORY_SIZE = 10; // Last N board hashes, to detect oscillators
+    static const int TILE_SIZE = 8;     // Activity tiles, one panel module each
+
 private:
-    bool *board;
-    bool *nextBoard;
+    // Rows are packed 64 cells to a word, bit 0 of word 0 being x = 0.
+    // Bits past the last column are always clear.
+    uint64_t *board;
+    uint64_t *nextBoard;
     int width;
     int height;
+    int wordsPerRow;
+    uint64_t lastWordMask; // Cells in use in the last word of a row
     bool wrapAround;
-    std::vector<unsigned long> boardHistory; // Store board hashes
-    int maxHistorySize = 10;                 // Store last N states to detect oscillators
+    unsigned long boardHistory[HISTORY_SIZE]; // Ring of board hashes
+    int historySize;
+    int historyHead;                          // Next slot to write
     unsigned int generationCount;
     unsigned int maxGenerations;
+    unsigned int finalPeriod;  // Period detected by the last finished game (0 = generation limit)
+    uint32_t seed;             // Seed used by the last randomize(seed) call; 0 after randomize()
+    uint64_t *scratch;         // Working tiles for stepN(), allocated on first use
+    uint64_t *rowBuffers;      // Three rows with guard words for the packed kernels
+    LifeEngine engine;
+    LifeRowKernel rowKernel;
+    bool nextValid;            // nextBoard already holds the next generation
+
+    // ENGINE_INCREMENTAL state. The counts and hash describe `board` while
+    // countsValid; nextBoard differs from it in exactly the cells of `changes`.
+    uint8_t *neighbourCounts;
+    LifeVector<int> changes;        // Cells (y * width + x) that flipped last generation
+    LifeVector<int> pendingChanges; // Cells that flip when nextBoard is committed
+    unsigned long incrementalHash;
+    bool countsValid;
+    bool changesValid;               // `changes` leads from the previous board to this one
+
+    // Statistics of `board`, and those worked out along with nextBoard
+    LifeStats stats;
+    LifeStats nextStats;
+    LifeVector<uint8_t> tileActivity; // Cells changed in each tile, row by row
+    LifeVector<uint8_t> nextTileActivity;
+    int tilesWide;
+    int tilesHigh;
+    bool statsValid; // stats describe `board`; an edit means a recount
+    bool boxValid;   // Else stats' box may be too big: a cell on its edge died
+    bool statsTracked;
 
 public:
     GameOfLife(int w, int h, bool wrap = true, unsigned int maxGen = 180);
@@ -20,16 +85,82 @@ public:
     ~GameOfLife();
 
     void randomize();
+    void randomize(uint32_t seed); // Reproducible soup from a seed
     void computeNextGeneration();
+    // Advance k generations, each tile several generations at a time while it
+    // is cache-resident. Skips the per-generation finish checks. Faster than
+    // single steps only once the boards outgrow the cache (PSRAM on the
+    // ESP32); ENGINE_REFERENCE and ENGINE_INCREMENTAL step one at a time.
+    void stepN(unsigned int k);
     bool getCell(int x, int y) const;
     void setCell(int x, int y, bool state);
     int getWidth() const { return width; }
     int getHeight() const { return height; }
+    bool getWrapAround() const { return wrapAround; }
+
+    // False (and the engine unchanged) if this CPU cannot run it
+    bool setEngine(LifeEngine e);
+    LifeEngine getEngine() const { return engine; }
+    int getWordsPerRow() const { return wordsPerRow; }
+    const uint64_t *getRow(int y) const { return board + y * wordsPerRow; }
+    // Replace row y with wordsPerRow packed words
+    void setRow(int y, const uint64_t *words);
+
+    // Cells (y * width + x) that flipped in the last computeNextGeneration().
+    // Only ENGINE_INCREMENTAL keeps the list, and any edit voids it.
+    bool hasChangeList() const { return changesValid; }
+    const LifeVector<int> &getChangedCells() const { return changes; }
+
+    // Population, bounding box, births and deaths. Only the first call
+    // after an edit counts the board.
+    const LifeStats &getStats();
+    // Cells changed in each TILE_SIZE square since the board before, tile
+    // rows from y = 0, getTilesWide() to a row
+    const uint8_t *getTileActivity();
+    int getTilesWide() const { return tilesWide; }
+    int getTilesHigh() const { return tilesHigh; }
+    // Off by default, as it costs the packed kernels most of their speed;
+    // stepping then skips the statistics, and getStats() counts the board
+    // when asked, without births, deaths or activity.
+    void setStatsTracking(bool on)
+    {
+        statsTracked = on;
+        // A next generation worked out under the other setting has the
+        // wrong statistics, and the incremental engine's state goes with it
+        boardEdited();
+    }
 
     bool isGameFinished();
     void resetGenerations() { generationCount = 0; }
     unsigned int getGenerationCount() const { return generationCount; }
+    unsigned int getMaxGenerations() const { return maxGenerations; }
+    unsigned int getFinalPeriod() const { return finalPeriod; }
+    uint32_t getSeed() const { return seed; }
+    int getPopulation() const;
     unsigned long calculateBoardHash() const;
+    // Copy the history hashes, oldest first, into out[HISTORY_SIZE]; returns how many
+    int getHistory(unsigned long *out) const;
+    // Put back the progress of a saved game, oldest history hash first
+    void restoreState(unsigned int generations, unsigned int maxGen, unsigned int period,
+                      uint32_t s, const unsigned long *history, int count);
+
+    // Arena space for a w x h board (LIFE_STATIC_MEMORY), with the incremental
+    // engine's counts and change lists, not counting stepN()'s working tiles
+    static constexpr size_t arenaBytes(int w, int h)
+    {
+        return 2 * LifeArena::blockBytes((size_t)(w + 63) / 64 * h * 8) +
+               LifeArena::blockBytes(3 * ((size_t)(w + 63) / 64 + 2) * 8) +
+               2 * LifeArena::blockBytes((size_t)((w + TILE_SIZE - 1) / TILE_SIZE) *
+                                         ((h + TILE_SIZE - 1) / TILE_SIZE)) +
+               LifeArena::blockBytes((size_t)w * h) +
+               2 * LifeArena::blockBytes((size_t)w * h * sizeof(int));
+    }
+    // Dimensions a board can take: both positive, with every cell index
+    // (y * width + x) in an int. For sizes read from files.
+    static constexpr bool validSize(uint64_t w, uint64_t h)
+    {
+        return w > 0 && h > 0 && w <= INT_MAX && h <= INT_MAX && w * h <= INT_MAX;
+    }
     void clearHistory();
     void clear();
 
@@ -41,5 +172,29 @@ public:
 
 private:
     int countNeighbors(int x, int y) const;
-    int getIndex(int x, int y) const;
+    void computeNext();
+    void computeNextReference();
+    void computeNextPacked();
+    void computeNextIncremental();
+    void rebuildCounts();
+    void evaluateCell(int i);
+    void commitChanges();
+    int neighbourCells(int i, int *out) const;
+    unsigned long fullBoardHash() const;
+    void boardEdited() { nextValid = countsValid = changesValid = false; }
+    void cellsEdited()
+    {
+        boardEdited();
+        statsValid = false;
+    }
+    void resetStats(LifeStats &s, LifeVector<uint8_t> &activity) const;
+    void addRowStats(int y, int w0, const uint64_t *cur, const uint64_t *next, int words, LifeStats &s,
+                     uint8_t *activity) const;
+    void commitStats();
+    void countStats();
+    uint64_t cellsIn(int y0, int y1, int w0, int w1) const;
+    void shrinkBox();
+    void fillGuardedRow(int y, uint64_t *dst) const;
+    uint64_t extractWord(int y, int x) const;
+    void stepTile(int wx, int y0, int tileWords, int tileRows, int depth);
 };
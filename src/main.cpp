@@ -6,8 +6,8 @@
 // a web browser and this will display as a scrolling message on
 // the display.
 //
-// IP address for the ESP32 is displayed on the scrolling display
-// after startup initialization and connected to the WiFi network.
+// Game of Life starts as soon as the display is initialised; the IP
+// address for the ESP32 scrolls across once the WiFi network connects.
 //
 // Connections for ESP32 hardware SPI are:
 // Vcc       3.3V - A few matrices seem to work at 3.3V
@@ -18,14 +18,47 @@
 //
 
 #include <WiFi.h>
-#include <WiFiServer.h>
+#include "LifeArena.h"
 #include <MD_MAX72xx.h>
 #include "LedPanel.h"
 #include "life.h"
+#include "SoupScreener.h"
+#include "SparseLife.h"
+#include "LifeNode.h"
+#include "LifeSnapshot.h"
+#include "LifeRecording.h"
+#include "SocketServer.h"
+#include "PanelCompositor.h"
+#include "LifeViewer.h"
+#include "WebAssets.h"
+#include "LoopScheduler.h"
+#include "PanelChains.h"
+#include "LifeTrace.h"
 
-#define PRINT_CALLBACK 0
 #define DEBUG 0
 #define LED_HEARTBEAT 0
+#define UNBOUNDED_PLANE 0 // Run games on an unbounded plane seen through a viewport
+#define DISTRIBUTED_NODE 0 // Run one tile of a board spread over several panels
+#define GENERATIONS_PER_FRAME 1 // Time-lapse: more than 1 skips generations between frames
+#define SNAPSHOT_INTERVAL_MS 60000 // Save the game to NVS this often so a reset resumes it (0 = never)
+#define SNAPSHOT_KEY "board"
+#define RECORD_GAMES 1 // Record each game in RAM so the end of game effect can replay it
+#define REPLAY_SPEEDUP 4
+#define SAVE_RECORDINGS 0 // Also keep the last finished game in SPIFFS as /last.lrec
+#define RECORD_KEYFRAME 64
+#define RECORD_BYTES 16384
+#define LIVE_VIEWER 1 // Stream the panel to the web page over a WebSocket
+#define LIVE_PORT 81 // Also in web/live.js
+#define LIVE_VIEWERS 2
+#define POWER_SAVE 1 // Sleep between ticks and slow quiet boards down
+#define FRAME_MS 333       // Generation rate of a busy board
+#define IDLE_FRAME_MS 1000 // ...and of one where almost nothing changes
+#define ACTIVE_CELLS 8     // Cells changed per generation that count as busy
+#define PANEL_CHAINS 0 // Split the modules over VSPI and HSPI, which send at the same time
+
+#if SAVE_RECORDINGS
+#include <SPIFFS.h>
+#endif
 
 #if DEBUG
 #define PRINT(s, v)     \
@@ -66,20 +99,119 @@ MD_MAX72XX mx = MD_MAX72XX(HARDWARE_TYPE, CS_PIN, MAX_DEVICES);
 // Arbitrary pins
 // MD_MAX72XX mx = MD_MAX72XX(HARDWARE_TYPE, DATA_PIN, CLK_PIN, CS_PIN, MAX_DEVICES);
 
+#if PANEL_CHAINS
+// The first half of the modules stay on VSPI; the chain is cut there and
+// the rest are wired to HSPI. mx is then only used for its font.
+constexpr PanelChains::Chain panelChains[] = {
+    {PanelChains::CHAIN_SPI, PanelChains::HOST_VSPI, CLK_PIN, DATA_PIN, CS_PIN, MAX_DEVICES / 2},
+    {PanelChains::CHAIN_SPI, PanelChains::HOST_HSPI, 14, 13, 15, MAX_DEVICES - MAX_DEVICES / 2},
+};
+#define PANEL_CHAIN_COUNT (int)(sizeof(panelChains) / sizeof(panelChains[0]))
+#endif
+
 // Prototypes
 void startNewMessage(const char *msg);
 
 
 LedPanel lp(mx, SCREEN_DEVICE_WIDTH, SCREEN_DEVICE_HEIGHT);
 
+// Bottom to top. Text scrolls in a band over the board, which keeps running.
+enum
+{
+  LAYER_LIFE,
+  LAYER_TICKER,
+  LAYER_EFFECT,
+  LAYER_COUNT
+};
+
+#if LIFE_STATIC_MEMORY
+#if UNBOUNDED_PLANE || DISTRIBUTED_NODE
+#error "LIFE_STATIC_MEMORY only sizes the arena for the single panel game"
+#endif
+#define BOARD_WIDTH (SCREEN_DEVICE_WIDTH * 8)
+#define BOARD_HEIGHT (SCREEN_DEVICE_HEIGHT * 8)
+#define MAX2(a, b) ((a) > (b) ? (a) : (b))
+// Long-lived: the board with its engine state, the screener's batch and the
+// recording. Temporaries are a snapshot being saved, served or loaded, or a
+// replay; room for two, as one can be stranded under the screener's batch
+// when that task allocates while setup() is restoring a snapshot.
+const size_t ARENA_BYTES =
+    GameOfLife::arenaBytes(BOARD_WIDTH, BOARD_HEIGHT) +
+    PanelCompositor::arenaBytes(BOARD_WIDTH, BOARD_HEIGHT, LAYER_COUNT) +
+#if PANEL_CHAINS
+    PanelChains::arenaBytes(panelChains, PANEL_CHAIN_COUNT) +
+#endif
+#if LIVE_VIEWER
+    LifeViewer::arenaBytes(BOARD_WIDTH, BOARD_HEIGHT, LIVE_VIEWERS) +
+#endif
+    SoupBatch::arenaBytes(BOARD_WIDTH, BOARD_HEIGHT) +
+#if RECORD_GAMES
+    LifeRecorder::arenaBytes(BOARD_WIDTH, BOARD_HEIGHT, RECORD_KEYFRAME, RECORD_BYTES) +
+    2 * MAX2(LifeSnapshot::arenaBytes(BOARD_WIDTH, BOARD_HEIGHT),
+             LifePlayer::arenaBytes(BOARD_WIDTH, BOARD_HEIGHT, RECORD_KEYFRAME, RECORD_BYTES));
+#else
+    2 * LifeSnapshot::arenaBytes(BOARD_WIDTH, BOARD_HEIGHT);
+#endif
+// Before anything that allocates from it
+alignas(8) static uint8_t arenaMemory[ARENA_BYTES];
+LifeArena arena(arenaMemory, ARENA_BYTES);
+#endif
+
+#if PANEL_CHAINS
+PanelChains chainOut(panelChains, PANEL_CHAIN_COUNT);
+#endif
 GameOfLife life(lp.width(), lp.height());
+PanelCompositor comp(lp, LAYER_COUNT);
+#if LIVE_VIEWER
+LifeViewer viewer(LIVE_PORT, lp.width(), lp.height(), LIVE_VIEWERS);
+uint32_t liveFrame = 0;
+#endif
+
+#if UNBOUNDED_PLANE
+// Gliders fly off instead of wrapping back into the gun; the viewport
+// follows the centre of mass
+SparseLife plane;
+LifeViewport view(lp.width(), lp.height());
+#endif
+
+#if DISTRIBUTED_NODE
+// Every panel runs the same firmware apart from NODE_INDEX. Panels are
+// numbered row by row across the installation.
+#define NODE_INDEX 0
+#define NODE_SEED 12345 // Shared so every node starts from the same board
+#define NODE_TIMEOUT_MS 50
+const char *const nodeHosts[] = {"192.168.1.50", "192.168.1.51"};
+const LifeNode::Config nodeConfig = {2, 1, SCREEN_DEVICE_WIDTH * 8, SCREEN_DEVICE_HEIGHT * 8,
+                                     NODE_INDEX, 1, 47000, nodeHosts, 20};
+LifeNode node(nodeConfig);
+#endif
+
+#if RECORD_GAMES && !UNBOUNDED_PLANE && !DISTRIBUTED_NODE
+// Keyframe every 64 generations; a 32x8 game rarely needs more than a few KB
+LifeRecorder recorder(RECORD_KEYFRAME, RECORD_BYTES);
+#endif
+
+// Decides how long loop() may sleep, and keeps the power and latency figures
+LoopScheduler sched;
+
+// Screens random soups on the other core so random games are long-lived
+SoupScreener screener(lp.width(), lp.height());
 
 // WiFi login parameters - network name and password
 const char ssid[] = "Post_Office_85D1";
 const char password[] = "vYT7tPVvr9";
 
-// WiFi Server object and parameters
-WiFiServer server(80);
+// Network bring-up runs from loop() alongside the display. A failed attempt
+// or a dropped link is retried after a backoff that doubles each time.
+#define WIFI_CONNECT_TIMEOUT_MS 20000
+#define WIFI_BACKOFF_MIN_MS 1000
+#define WIFI_BACKOFF_MAX_MS 60000
+
+// Web server. WiFiClient can only send by waiting for the whole reply to go,
+// and allocates a socket handle per connection.
+SocketServer server(80);
+#define WEB_CHUNK_BYTES 4096      // Most handed to the socket per loop() pass
+#define WEB_SEND_TIMEOUT_MS 5000 // Give up on a client that takes nothing for this long
 
 // Global message buffers shared by Wifi and Scrolling functions
 const uint8_t MESG_SIZE = 255;
@@ -89,39 +221,67 @@ const uint8_t SCROLL_DELAY = 75;
 char curMessage[MESG_SIZE];
 char newMessage[MESG_SIZE];
 bool newMessageAvailable = false;
+bool lifeDrawn = false; // LAYER_LIFE holds the board as it was before the last step
+
+// Boot timing, in millis() since reset (0 = not yet)
+uint32_t firstFrameMs = 0;
+uint32_t networkUpMs = 0;
+uint16_t wifiReconnects = 0;
+
+uint32_t frameMs = FRAME_MS; // Current generation interval
+
+// The page and its script are in web/, gzipped into WebAssets.h at build time
+const WebAsset *findAsset(const char *request)
+{
+  // "GET /path?query HTTP/1.1"
+  if (strncmp(request, "GET ", 4) != 0)
+    return nullptr;
+  const char *path = request + 4;
+  size_t len = strcspn(path, " ?");
+  for (int i = 0; i < WEB_ASSET_COUNT; i++)
+  {
+    if (strlen(webAssets[i].path) == len && strncmp(webAssets[i].path, path, len) == 0)
+      return &webAssets[i];
+  }
+  return nullptr;
+}
+
+// The status line and headers of every reply, in CRLF lines. Each
+// connection carries one request, so all say Connection: close, and a body
+// of unknown length (-1) ends with the connection. extra holds any further
+// header lines, each ending in CRLF.
+void sendHeaders(SocketClient &client, const char *status, const char *type, long length,
+                 const char *extra = "")
+{
+  char reply[256];
+  int n = snprintf(reply, sizeof(reply), "HTTP/1.1 %s\r\n", status);
+  if (type)
+    n += snprintf(reply + n, sizeof(reply) - n, "Content-Type: %s\r\n", type);
+  if (length >= 0)
+    n += snprintf(reply + n, sizeof(reply) - n, "Content-Length: %ld\r\n", length);
+  snprintf(reply + n, sizeof(reply) - n, "%sConnection: close\r\n\r\n", extra);
+  client.print(reply);
+}
+
+// A one line report
+void sendText(SocketClient &client, const char *report)
+{
+  sendHeaders(client, "200 OK", "text/plain", strlen(report));
+  client.print(report);
+}
+
+#if LIFE_TRACE
+// Trace dumps, to lifetrace by way of curl or a serial capture
+void traceToClient(void *context, const char *text, size_t len)
+{
+  static_cast<SocketClient *>(context)->write((const uint8_t *)text, len);
+}
 
-const char WebResponse[] = "HTTP/1.1 200 OK\nContent-Type: text/html\n\n";
-
-const char WebPage[] =
-    "<!DOCTYPE html>"
-    "<html>"
-    "<head>"
-    "<title>MajicDesigns Test Page</title>"
-
-    "<script>"
-    "strLine = \"\";"
-
-    "function SendText()"
-    "{"
-    "  nocache = \"/&nocache=\" + Math.random() * 1000000;"
-    "  var request = new XMLHttpRequest();"
-    "  strLine = \"&MSG=\" + document.getElementById(\"txt_form\").Message.value;"
-    "  request.open(\"GET\", strLine + nocache, false);"
-    "  request.send(null);"
-    "}"
-    "</script>"
-    "</head>"
-
-    "<body>"
-    "<p><b>MD_MAX72xx set message</b></p>"
-
-    "<form id=\"txt_form\" name=\"frmText\">"
-    "<label>Msg:<input type=\"text\" name=\"Message\" maxlength=\"255\"></label><br><br>"
-    "</form>"
-    "<br>"
-    "<input type=\"submit\" value=\"Send Text\" onclick=\"SendText()\">"
-    "</body>"
-    "</html>";
+void traceToSerial(void *, const char *text, size_t len)
+{
+  Serial.write((const uint8_t *)text, len);
+}
+#endif
 
 const char *err2Str(wl_status_t code)
 {
@@ -200,19 +360,30 @@ void handleWiFi(void)
   static enum { S_IDLE,
                 S_WAIT_CONN,
                 S_READ,
+                S_HEADERS,
                 S_EXTRACT,
                 S_RESPONSE,
+                S_SEND,
                 S_DISCONN } state = S_IDLE;
   static char szBuf[1024];
   static uint16_t idxBuf = 0;
-  static WiFiClient client;
+  static char header[64];      // Current header line, cut short if longer
+  static uint8_t idxHeader = 0;
+  static char ifNoneMatch[24]; // ETag the browser already has
+  static bool isMessage;       // The request carried text to scroll
+  static SocketClient client;
   static uint32_t timeStart;
+  static const uint8_t *sendData; // Rest of an asset for S_SEND
+  static size_t sendLeft;
 
+  TRACE_SCOPE(TRACE_WIFI, state);
   switch (state)
   {
   case S_IDLE: // initialize
     PRINTS("\nS_IDLE");
     idxBuf = 0;
+    idxHeader = 0;
+    ifNoneMatch[0] = '\0';
     state = S_WAIT_CONN;
     break;
 
@@ -222,7 +393,11 @@ void handleWiFi(void)
     if (!client)
       break;
     if (!client.connected())
+    {
+      // Accepted and already closed by the peer, as after a cancelled preconnect
+      client.stop();
       break;
+    }
 
 #if DEBUG
     char szTxt[20];
@@ -237,20 +412,51 @@ void handleWiFi(void)
 
   case S_READ: // get the first line of data
     PRINTS("\nS_READ");
-    while (client.available())
+    while (state == S_READ && client.available())
     {
       char c = client.read();
-      if ((c == '\r') || (c == '\n'))
+      if (c == '\n')
       {
         szBuf[idxBuf] = '\0';
-        client.flush();
         PRINT("\nRecv: ", szBuf);
-        state = S_EXTRACT;
+        state = S_HEADERS;
       }
-      else
+      else if (c != '\r' && idxBuf < sizeof(szBuf) - 1)
         szBuf[idxBuf++] = (char)c;
     }
-    if (millis() - timeStart > 1000)
+    if (state == S_READ && millis() - timeStart > 1000)
+    {
+      PRINTS("\nWait timeout");
+      state = S_DISCONN;
+    }
+    break;
+
+  case S_HEADERS: // up to the blank line, keeping If-None-Match
+    while (state == S_HEADERS && client.available())
+    {
+      char c = client.read();
+      if (c == '\n')
+      {
+        header[idxHeader] = '\0';
+        if (idxHeader == 0)
+        {
+          client.flush();
+          state = S_EXTRACT;
+        }
+        else if (strncasecmp(header, "If-None-Match:", 14) == 0)
+        {
+          const char *tag = header + 14;
+          while (*tag == ' ')
+            tag++;
+          strncpy(ifNoneMatch, tag, sizeof(ifNoneMatch) - 1);
+          ifNoneMatch[sizeof(ifNoneMatch) - 1] = '\0';
+        }
+        idxHeader = 0;
+      }
+      else if (c != '\r' && idxHeader < sizeof(header) - 1)
+        header[idxHeader++] = c;
+    }
+    if (state == S_HEADERS && millis() - timeStart > 1000)
     {
       PRINTS("\nWait timeout");
       state = S_DISCONN;
@@ -261,6 +467,7 @@ void handleWiFi(void)
     PRINTS("\nS_EXTRACT");
     // Extract the string from the message if there is one
     newMessageAvailable = getText(szBuf, newMessage, MESG_SIZE);
+    isMessage = newMessageAvailable;
     if (newMessageAvailable)
     {
       startNewMessage(newMessage);
@@ -270,12 +477,155 @@ void handleWiFi(void)
     break;
 
   case S_RESPONSE: // send the response to the client
+  {
     PRINTS("\nS_RESPONSE");
-    // Return the response to the client (web page)
-    client.print(WebResponse);
-    client.print(WebPage);
+    TRACE_SCOPE(TRACE_WIFI_RESPONSE);
+    const WebAsset *asset = findAsset(szBuf);
+    if (isMessage)
+    {
+      // The page's request ignores the reply
+      sendHeaders(client, "204 No Content", nullptr, -1);
+    }
+    else if (strncmp(szBuf, "GET /snapshot", 13) == 0)
+    {
+      // The current board, e.g. for lifesnap on a host
+      LifeVector<uint8_t> snap;
+      LifeSnapshot::save(life, snap);
+      sendHeaders(client, "200 OK", "application/octet-stream", snap.size());
+      client.write(snap.data(), snap.size());
+    }
+    else if (strncmp(szBuf, "GET /stats", 10) == 0)
+    {
+      // Kept by the engine as it steps; nothing is counted here
+      const LifeStats &st = life.getStats();
+      const uint8_t *activity = life.getTileActivity();
+      char report[256];
+      int n = snprintf(report, sizeof(report),
+                       "generation %u, population %d, %d births, %d deaths, box %d,%d to %d,%d, %d of %d tiles active\n",
+                       st.generation, st.population, st.births, st.deaths, st.minX, st.minY, st.maxX, st.maxY,
+                       st.activeTiles, life.getTilesWide() * life.getTilesHigh());
+      // The map below has a line per tile row, cut to fit the buffer
+      int mapWidth = life.getTilesWide() < (int)sizeof(report) - 2 ? life.getTilesWide() : (int)sizeof(report) - 2;
+      sendHeaders(client, "200 OK", "text/plain", strlen(report) + (long)life.getTilesHigh() * (mapWidth + 1));
+      client.print(report);
+      // One character per 8 x 8 tile, laid out as on the panel: '.' still,
+      // else how many cells changed, in eighths
+      for (int ty = life.getTilesHigh() - 1; ty >= 0; ty--)
+      {
+        n = 0;
+        for (int tx = 0; tx < life.getTilesWide() && n < (int)sizeof(report) - 2; tx++)
+        {
+          uint8_t changed = activity[ty * life.getTilesWide() + tx];
+          report[n++] = changed ? '0' + (changed + 7) / 8 : '.';
+        }
+        report[n++] = '\n';
+        report[n] = '\0';
+        client.print(report);
+      }
+    }
+    else if (strncmp(szBuf, "GET /boot", 9) == 0)
+    {
+      char report[96];
+      snprintf(report, sizeof(report), "first frame %u ms, network up %u ms, %u reconnects\n",
+               (unsigned)firstFrameMs, (unsigned)networkUpMs, (unsigned)wifiReconnects);
+      sendText(client, report);
+    }
+#if LIFE_STATIC_MEMORY
+    else if (strncmp(szBuf, "GET /memory", 11) == 0)
+    {
+      char report[128];
+      snprintf(report, sizeof(report), "arena %u of %u bytes in use, peak %u, %u failed allocations\n",
+               (unsigned)LifeArena::used(), (unsigned)LifeArena::capacity(),
+               (unsigned)LifeArena::peak(), (unsigned)LifeArena::failures());
+      sendText(client, report);
+    }
+#endif
+#if LIVE_VIEWER
+    else if (strncmp(szBuf, "GET /live ", 10) == 0)
+    {
+      char report[128];
+      snprintf(report, sizeof(report), "%d viewers, %u frames sent, %u skipped, %llu bytes\n",
+               viewer.getViewerCount(), (unsigned)viewer.getFramesSent(),
+               (unsigned)viewer.getFramesSkipped(), (unsigned long long)viewer.getBytesSent());
+      sendText(client, report);
+    }
+#endif
+#if PANEL_CHAINS
+    else if (strncmp(szBuf, "GET /panel", 10) == 0)
+    {
+      char report[160];
+      snprintf(report, sizeof(report), "%d chains, %d modules, last flush %u us (model %u us), %u transfers, %llu bits\n",
+               chainOut.getChainCount(), chainOut.getModuleCount(), (unsigned)chainOut.getLastFlushUs(),
+               (unsigned)(chainOut.getLastModelNs() / 1000), (unsigned)chainOut.getTransfers(),
+               (unsigned long long)chainOut.getBitsSent());
+      sendText(client, report);
+    }
+#endif
+#if LIFE_TRACE
+    else if (strncmp(szBuf, "GET /trace", 10) == 0)
+    {
+      // The ring as it stands, oldest first; recording carries on after
+      sendHeaders(client, "200 OK", "text/plain", -1);
+      LifeTrace::dump(traceToClient, &client);
+    }
+#endif
+    else if (strncmp(szBuf, "GET /power", 10) == 0)
+    {
+      // Current is estimated from the loop's time awake; see LoopScheduler.h.
+      // The screener on core 0 is reported beside it, not counted in it.
+      char report[288];
+      uint32_t awake = sched.getAwakePerMille();
+      uint32_t ua = sched.getEstimatedMicroamps();
+      uint32_t screening = millis() ? (uint32_t)((uint64_t)screener.getBusyMs() * 1000 / millis()) : 0;
+      snprintf(report, sizeof(report),
+               "loop awake %u.%u%%, about %u.%u mA (%s), screener busy %u.%u%% (not in the estimate), "
+               "frame every %u ms, latency avg %u ms max %u ms, %u frames, %u unchanged\n",
+               (unsigned)(awake / 10), (unsigned)(awake % 10), (unsigned)(ua / 1000), (unsigned)(ua % 1000 / 100),
+               sched.hasLightSleep() ? "light sleep" : "no light sleep", (unsigned)(screening / 10),
+               (unsigned)(screening % 10), (unsigned)frameMs,
+               (unsigned)sched.getLatencyAvgMs(), (unsigned)sched.getLatencyMaxMs(),
+               (unsigned)sched.getFrames(), (unsigned)sched.getUnchangedFrames());
+      sendText(client, report);
+    }
+    else if (asset && strcmp(ifNoneMatch, asset->etag) == 0)
+    {
+      // The browser's copy is current; Cache-Control makes it ask each time
+      char extra[96];
+      snprintf(extra, sizeof(extra), "ETag: %s\r\nCache-Control: no-cache\r\n", asset->etag);
+      sendHeaders(client, "304 Not Modified", nullptr, -1, extra);
+    }
+    else if (asset)
+    {
+      // Straight from flash, already gzipped; the body goes out from S_SEND
+      char extra[128];
+      snprintf(extra, sizeof(extra), "Content-Encoding: gzip\r\nETag: %s\r\nCache-Control: no-cache\r\n",
+               asset->etag);
+      sendHeaders(client, "200 OK", asset->type, asset->size, extra);
+      sendData = asset->data;
+      sendLeft = asset->size;
+      timeStart = millis();
+      state = S_SEND;
+      break;
+    }
+    else
+      sendHeaders(client, "404 Not Found", nullptr, 0);
     state = S_DISCONN;
-    break;
+  }
+  break;
+
+  case S_SEND: // as much of the body as the socket takes without waiting
+  {
+    int n = client.writeSome(sendData, sendLeft < WEB_CHUNK_BYTES ? sendLeft : WEB_CHUNK_BYTES);
+    if (n > 0)
+    {
+      sendData += n;
+      sendLeft -= n;
+      timeStart = millis();
+    }
+    if (n < 0 || sendLeft == 0 || millis() - timeStart > WEB_SEND_TIMEOUT_MS)
+      state = S_DISCONN;
+  }
+  break;
 
   case S_DISCONN: // disconnect client
     PRINTS("\nS_DISCONN");
@@ -287,6 +637,110 @@ void handleWiFi(void)
   default:
     state = S_IDLE;
   }
+
+  // What should wake loop() for the next step
+  if (state == S_WAIT_CONN)
+    sched.watch(server.fd());
+  else if ((state == S_READ || state == S_HEADERS) && !client.available())
+  {
+    sched.watch(client.fd());
+    sched.wakeIn(100); // For the read timeout
+  }
+  else if (state == S_SEND)
+    sched.watch(client.fd(), true);
+  else
+    sched.wakeIn(0);
+}
+
+bool handleNetwork(void)
+// Connect, start the server once there is an address, and reconnect with
+// backoff when the link drops. Returns true while the server is reachable.
+{
+  static enum { N_START,
+                N_CONNECTING,
+                N_UP,
+                N_BACKOFF } state = N_START;
+  static uint32_t timeStart;
+  static uint32_t backoff = WIFI_BACKOFF_MIN_MS;
+  static bool serverStarted = false;
+
+  TRACE_SCOPE(TRACE_NETWORK, state);
+  switch (state)
+  {
+  case N_START: // start an attempt; WiFi.begin() does not wait for it
+    PRINT("\nConnecting to ", ssid);
+    WiFi.begin(ssid, password);
+    timeStart = millis();
+    state = N_CONNECTING;
+    break;
+
+  case N_CONNECTING: // waiting for an address
+  {
+    wl_status_t status = WiFi.status();
+    if (status == WL_CONNECTED)
+    {
+      PRINTS("\nWiFi connected");
+      if (!serverStarted)
+      {
+        PRINTS("\nStarting Server");
+        server.begin();
+#if LIVE_VIEWER
+        if (!viewer.begin())
+          PRINTS("\nViewer start failed");
+#endif
+#if DISTRIBUTED_NODE
+        if (!node.begin())
+          PRINTS("\nNode start failed");
+#endif
+        serverStarted = true;
+      }
+      if (networkUpMs == 0)
+        networkUpMs = millis();
+
+      // Show the address, which may have changed after a reconnect
+      char ip[16];
+      sprintf(ip, "%d:%d:%d:%d", WiFi.localIP()[0], WiFi.localIP()[1], WiFi.localIP()[2], WiFi.localIP()[3]);
+      PRINT("\nAssigned IP ", ip);
+      startNewMessage(ip);
+      backoff = WIFI_BACKOFF_MIN_MS;
+      state = N_UP;
+    }
+    else if (status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL ||
+             millis() - timeStart > WIFI_CONNECT_TIMEOUT_MS)
+    {
+      PRINT("\nWiFi ", err2Str(status));
+      WiFi.disconnect();
+      timeStart = millis();
+      state = N_BACKOFF;
+    }
+  }
+  break;
+
+  case N_UP: // connected; watch for the link dropping
+    if (WiFi.status() != WL_CONNECTED)
+    {
+      PRINTS("\nWiFi lost");
+      wifiReconnects++;
+      WiFi.disconnect();
+      timeStart = millis();
+      state = N_BACKOFF;
+    }
+    break;
+
+  case N_BACKOFF: // wait before the next attempt
+    if (millis() - timeStart >= backoff)
+    {
+      PRINT("\nRetrying after ms ", backoff);
+      backoff = backoff * 2 < WIFI_BACKOFF_MAX_MS ? backoff * 2 : WIFI_BACKOFF_MAX_MS;
+      state = N_START;
+    }
+    break;
+  }
+
+  // Link changes are polled; a connection attempt is watched more closely
+  if (state != N_UP)
+    sched.wakeIn(100);
+  return state == N_UP;
 }
 
 class ScrollState
@@ -308,19 +762,6 @@ public:
 
 ScrollState scrollState;
 
-void scrollDataSink(uint8_t dev, MD_MAX72XX::transformType_t t, uint8_t col)
-// Callback function for data that is being scrolled off the display
-{
-#if PRINT_CALLBACK
-  Serial.print("\n cb ");
-  Serial.print(dev);
-  Serial.print(' ');
-  Serial.print(t);
-  Serial.print(' ');
-  Serial.println(col);
-#endif
-}
-
 bool messageComplete = false;  // The end of the message is on the display
 bool messageDone = false;  // The message has scrolled off the display
 int extraScrollColumns = MAX_DEVICES * COL_SIZE; // Width of display
@@ -330,6 +771,7 @@ uint8_t scrollDataSource(uint8_t dev, MD_MAX72XX::transformType_t t)
   static uint8_t cBuf[8];
   static int remainingScrolls = 0;
   uint8_t colData = 0;
+  TRACE_SCOPE(TRACE_SCROLL_CALLBACK, scrollState.state);
 
   switch (scrollState.state)
   {
@@ -410,16 +852,36 @@ bool isScrollingComplete()
            scrollState.state == ScrollState::S_IDLE));
 }
 
-void scrollText(void)
+// Top row of the ticker band: centred, or the whole of an 8 row panel
+int tickerTop() { return (lp.height() - ROW_SIZE) / 2; }
+
+uint32_t scrollText(void)
+// Returns the ms until the next column is due
 {
   static uint32_t prevTime = 0;
 
   // Is it time to scroll the text?
   if (millis() - prevTime >= SCROLL_DELAY)
   {
-    mx.transform(MD_MAX72XX::TSL); // scroll along - the callback will load all the data
-    prevTime = millis();           // starting point for next time
+    TRACE_SCOPE(TRACE_SCROLL);
+    // Shift the band one column left and feed the next column in on the right.
+    // Bit 0 of a column is the top row; y counts up from the bottom.
+    uint8_t colData = scrollDataSource(0, MD_MAX72XX::TSL);
+    int words = comp.getWordsPerRow();
+    int last = lp.width() - 1;
+    for (int i = 0; i < ROW_SIZE; i++)
+    {
+      uint64_t *row = comp.getRow(LAYER_TICKER, tickerTop() + ROW_SIZE - 1 - i);
+      for (int w = 0; w < words; w++)
+        row[w] = (row[w] >> 1) | (w + 1 < words ? row[w + 1] << 63 : 0);
+      if ((colData >> i) & 1)
+        row[last / 64] |= (uint64_t)1 << (last % 64);
+    }
+    comp.markDirty(LAYER_TICKER, 0, tickerTop(), last, tickerTop() + ROW_SIZE - 1);
+    prevTime = millis(); // starting point for next time
   }
+  uint32_t since = millis() - prevTime;
+  return since < SCROLL_DELAY ? SCROLL_DELAY - since : 0;
 }
 
 void startNewMessage(const char *msg)
@@ -428,11 +890,13 @@ void startNewMessage(const char *msg)
   newMessageAvailable = true;
   messageComplete = false;
   messageDone = false;
+  comp.clearLayer(LAYER_TICKER);
+  comp.setVisible(LAYER_TICKER, true);
 }
 
 void spotRun()
 {
-  mx.clear();
+  lp.clear();
   for (int y = 0; y < lp.height(); y++)
   {
     for (int x = 0; x < lp.width(); x++)
@@ -446,7 +910,7 @@ void spotRun()
 
 void drawBorder()
 {
-  mx.clear();
+  lp.clear();
 
   lp.drawLine(0, 0, lp.width() - 1, 0);
   lp.drawLine(0, lp.height() - 1, lp.width() - 1, lp.height() - 1);
@@ -456,7 +920,7 @@ void drawBorder()
 
 void identifyPanel()
 {
-  mx.clear();
+  lp.clear();
   // A dot at 0,0
   lp.drawPoint(0, 0, true);
   // A diagronal at 7,7
@@ -473,17 +937,34 @@ void identifyPanel()
   lp.drawPoint(1, 6, true);
 }
 
+// A random soup, preferring a pre-screened long-lived seed
+void seedSoup()
+{
+  SoupResult soup;
+  if (screener.takeSeed(soup))
+  {
+    PRINT(" seed ", soup.seed);
+    PRINT(" lifespan ", soup.lifespan);
+    life.randomize(soup.seed);
+  }
+  else
+    life.randomize();
+}
+
 void startNextGame()
 {
   PRINTS("\nstartNextGame");
+  TRACE_SCOPE(TRACE_NEW_GAME);
   int choice = random(100);
+  bool gliderGun = false;
   life.resetGenerations();
+  lifeDrawn = false;
 
   if (choice < 40)
   {
     PRINTS(" 40% chance to randomize");
     // 40% chance to randomize
-    life.randomize();
+    seedSoup();
   }
   else if (choice < 50)
   {
@@ -496,11 +977,14 @@ void startNextGame()
     PRINTS(" 10% chance to create glider gun");
     // 10% chance to create glider gun
     life.createGliderGun(0, 0);
+    gliderGun = true;
   }
   else if (choice < 70)
   {
-    // Print Life!
+    PRINTS(" 10% chance to print Life! over a new soup");
+    // Print Life!, over a fresh board rather than the one that just finished
     startNewMessage("Life!");
+    seedSoup();
   }
   else
   {
@@ -526,11 +1010,59 @@ void startNextGame()
       life.createBlinker(x, y);
     }
   }
+
+#if UNBOUNDED_PLANE
+  // Move the seeded board onto the plane, where the gun fits in full
+  plane.clear();
+  plane.clearHistory();
+  plane.resetGenerations();
+  if (gliderGun)
+    plane.createGliderGun(0, 0);
+  else
+    plane.loadBoard(life, 0, 0);
+  view.setMode(LifeViewport::FOLLOW_CENTROID);
+  view.centreOn(life.getWidth() / 2, life.getHeight() / 2);
+#else
+  (void)gliderGun;
+#endif
+
+#if RECORD_GAMES && !UNBOUNDED_PLANE && !DISTRIBUTED_NODE
+  recorder.begin(life);
+#endif
+}
+
+#if RECORD_GAMES && !UNBOUNDED_PLANE && !DISTRIBUTED_NODE
+// Play back the game that just ended, REPLAY_SPEEDUP times faster
+void replayGame()
+{
+  LifePlayer player;
+  const LifeVector<uint8_t> &stream = recorder.getStream();
+  if (!player.open(stream.data(), stream.size()))
+    return;
+
+  do
+  {
+    lp.beginFrame();
+    lp.clear();
+    for (int y = 0; y < player.getHeight(); y++)
+    {
+      for (int x = 0; x < player.getWidth(); x++)
+        lp.drawPoint(x, y, player.getCell(x, y));
+    }
+    lp.endFrame();
+    delay(333 / REPLAY_SPEEDUP);
+  } while (player.next());
 }
+#endif
 
 void showEndGameEffect()
 {
+#if RECORD_GAMES && !UNBOUNDED_PLANE && !DISTRIBUTED_NODE
+  int effect = random(5);
+#else
   int effect = random(4);
+#endif
+  TRACE_SCOPE(TRACE_EFFECT, effect);
   switch (effect)
   {
   case 0:
@@ -547,24 +1079,113 @@ void showEndGameEffect()
     break;
   case 3:
     PRINTS("\nFlash");
-    lp.flash();
+    // Invert whatever is showing, text included
+    for (int i = 0; i < 3; i++)
+    {
+      comp.fillLayer(LAYER_EFFECT);
+      comp.compose();
+      delay(200);
+      comp.clearLayer(LAYER_EFFECT);
+      comp.compose();
+      delay(200);
+    }
+    break;
+#if RECORD_GAMES && !UNBOUNDED_PLANE && !DISTRIBUTED_NODE
+  case 4:
+    PRINTS("\nReplay");
+    replayGame();
     break;
+#endif
   }
   delay(1000);
 }
 
-void drawLifeBoard()
+bool lifeCell(int x, int y)
+{
+#if UNBOUNDED_PLANE
+  return view.getCell(plane, x, y);
+#elif DISTRIBUTED_NODE
+  return node.getCell(x, y);
+#else
+  return life.getCell(x, y);
+#endif
+}
+
+// Step the game being shown; false once it has finished. Without
+// checkFinish it only steps.
+bool advanceLife(bool checkFinish)
 {
-  mx.clear();
-  // Update LED matrix
-  for (int y = 0; y < life.getHeight(); y++)
+  TRACE_SCOPE(TRACE_ADVANCE);
+#if UNBOUNDED_PLANE
+  if (checkFinish && plane.isGameFinished())
+    return false;
+  plane.computeNextGeneration();
+  view.update(plane);
+#elif DISTRIBUTED_NODE
+  // One endless game across the installation; a late neighbour only
+  // delays the next frame. The tile holds still until the node has
+  // started, once WiFi is up.
+  if (node.isStarted())
+    node.advance(NODE_TIMEOUT_MS);
+  (void)checkFinish;
+#else
+  if (checkFinish && life.isGameFinished())
+    return false;
+#if GENERATIONS_PER_FRAME > 1
+  life.stepN(GENERATIONS_PER_FRAME);
+#else
+  life.computeNextGeneration();
+#endif
+#if RECORD_GAMES
+  recorder.record(life);
+#endif
+#endif
+  return true;
+}
+
+int drawLifeBoard()
+// Returns the number of cells that changed on the panel
+{
+  TRACE_SCOPE(TRACE_DRAW);
+  int changed = 0;
+  // Into LAYER_LIFE; compose() sends the device rows that changed
+#if !UNBOUNDED_PLANE && !DISTRIBUTED_NODE
+  if (lifeDrawn && life.hasChangeList())
   {
-    for (int x = 0; x < life.getWidth(); x++)
+    // Only the cells born or died in the last step need redrawing
+    const LifeVector<int> &changes = life.getChangedCells();
+    for (size_t i = 0; i < changes.size(); i++)
     {
-      // Set LED state based on cell state
-      lp.drawPoint(x, y, life.getCell(x, y));
+      int x = changes[i] % life.getWidth();
+      int y = changes[i] / life.getWidth();
+      changed += comp.setPixel(LAYER_LIFE, x, y, life.getCell(x, y));
     }
   }
+  else
+  {
+    // The layer's rows are packed the same way as the board's
+    for (int y = 0; y < life.getHeight(); y++)
+      changed += comp.setRow(LAYER_LIFE, y, life.getRow(y));
+  }
+#else
+  for (int y = 0; y < lp.height(); y++)
+  {
+    for (int x = 0; x < lp.width(); x++)
+      changed += comp.setPixel(LAYER_LIFE, x, y, lifeCell(x, y));
+  }
+#endif
+  lifeDrawn = true;
+  return changed;
+}
+
+uint32_t frameInterval(int changed)
+// Quiet boards slow down towards IDLE_FRAME_MS, in step with how little moves
+{
+#if POWER_SAVE
+  if (changed < ACTIVE_CELLS)
+    return IDLE_FRAME_MS - (uint32_t)(IDLE_FRAME_MS - FRAME_MS) * changed / ACTIVE_CELLS;
+#endif
+  return FRAME_MS;
 }
 
 void setup(void)
@@ -572,6 +1193,8 @@ void setup(void)
 #if DEBUG
   Serial.begin(115200);
   PRINTS("\n[MD_MAX72XX WiFi Message Display]\nType a message for the scrolling display from your internet browser");
+#elif LIFE_TRACE
+  Serial.begin(115200);
 #endif
 
 #if LED_HEARTBEAT
@@ -581,46 +1204,87 @@ void setup(void)
 
   // Display initialization
   PRINTS("\nInitializing Display");
+#if PANEL_CHAINS
+  // mx would claim VSPI; it only needs its font loading
+  mx.setFont(nullptr);
+  if (!chainOut.begin())
+    PRINTS("\nPanel chains failed to start");
+  lp.setOutput(&chainOut);
+#else
   mx.begin();
-  mx.control(MD_MAX72XX::INTENSITY, 0);
+#endif
+  lp.setIntensity(0);
   // Flip the characters horizontally so they display correctly
   // Rotate the entire display 180 degrees to fix the panel order from 1->4 instead of 4->1
   // mx.transform(MD_MAX72XX::TFLR);     // Flip characters horizontally
   // mx.set.setRotation(MD_MAX72XX::MD_ROTATION_180); // Reverse panel order
 
-  mx.setShiftDataInCallback(scrollDataSource);
-  mx.setShiftDataOutCallback(scrollDataSink);
+  // Text is fed to the ticker layer by scrollText() rather than by
+  // MD_MAX72XX's shift callbacks
+  for (int i = 0; i < ROW_SIZE; i++)
+  {
+    uint64_t *mask = comp.getMaskRow(LAYER_TICKER, tickerTop() + i);
+    for (int w = 0; w < comp.getWordsPerRow(); w++)
+      mask[w] = ~(uint64_t)0;
+  }
+  comp.setOp(LAYER_TICKER, PanelCompositor::OP_MASK);
+  comp.setOp(LAYER_EFFECT, PanelCompositor::OP_XOR);
 
   curMessage[0] = newMessage[0] = '\0';
-
-  // Connect to and initialize WiFi network
-  PRINT("\nConnecting to ", ssid);
-
-  WiFi.begin(ssid, password);
-
-  while (WiFi.status() != WL_CONNECTED)
+  // Nothing to scroll yet: Life starts on the first pass through loop(),
+  // and the IP address is shown once WiFi has one
+  messageComplete = messageDone = true;
+
+  // Mostly still boards with a few moving parts: step only around the changes
+  life.setEngine(ENGINE_INCREMENTAL);
+  // Kept from its change list, for /stats
+  life.setStatsTracking(true);
+#if SAVE_RECORDINGS
+  SPIFFS.begin(true);
+#endif
+  screener.begin();
+#if POWER_SAVE
+  if (sched.begin())
+    PRINTS("\nLight sleep enabled");
+#endif
+  startNextGame();
+#if SNAPSHOT_INTERVAL_MS && !UNBOUNDED_PLANE && !DISTRIBUTED_NODE
+  // Carry on with the game that was running before a reset
+  if (LifeSnapshot::loadNvs(life, SNAPSHOT_KEY))
   {
-    PRINT("\n", err2Str(WiFi.status()));
-    // busy wait delay
-    uint32_t t = millis();
-    while (millis() - t <= 1000)
-      yield();
+    PRINT("\nResumed at generation ", life.getGenerationCount());
+#if RECORD_GAMES
+    recorder.begin(life);
+#endif
   }
-  PRINTS("\nWiFi connected");
-
-  // Start the server
-  PRINTS("\nStarting Server");
-  server.begin();
+#endif
 
-  // Set up first message as the IP address
-  sprintf(curMessage, "%d:%d:%d:%d", WiFi.localIP()[0], WiFi.localIP()[1], WiFi.localIP()[2], WiFi.localIP()[3]);
-  PRINT("\nAssigned IP ", curMessage);
+#if DISTRIBUTED_NODE
+  {
+    GameOfLife installation(nodeConfig.gridWidth * nodeConfig.tileWidth,
+                            nodeConfig.gridHeight * nodeConfig.tileHeight);
+    installation.randomize(NODE_SEED);
+    node.loadTile(installation);
+  }
+  // The node starts with the server; until then it waits out each exchange
+#endif
 
-  startNextGame();
+#if LIFE_STATIC_MEMORY
+  PRINT("\nArena bytes used ", LifeArena::used());
+  PRINT(" of ", LifeArena::capacity());
+  PRINT(", peak ", LifeArena::peak());
+#endif
 }
 
 void loop(void)
 {
+  TRACE_MARK(TRACE_LOOP, 0);
+  sched.beginPass();
+#if LIFE_TRACE
+  // 't' on the serial port dumps the trace
+  if (Serial.available() && Serial.read() == 't')
+    LifeTrace::dump(traceToSerial, nullptr);
+#endif
 #if LED_HEARTBEAT
   static uint32_t timeLast = 0;
 
@@ -629,32 +1293,94 @@ void loop(void)
     digitalWrite(HB_LED, digitalRead(HB_LED) == LOW ? HIGH : LOW);
     timeLast = millis();
   }
+  sched.wakeIn(HB_LED_TIME - (millis() - timeLast));
+#endif
+  static bool networkUp = false;
+  if (networkUp)
+  {
+    handleWiFi();
+#if LIVE_VIEWER
+    viewer.service();
+    viewer.watch(sched);
+#endif
+  }
+#if DISTRIBUTED_NODE
+  if (node.isStarted())
+  {
+    node.service(0); // Answer neighbours that are waiting on us
+    sched.wakeIn(0); // They cannot wait for us to wake
+  }
 #endif
-  handleWiFi();
 
   static uint32_t lastUpdate = 0;
+  // Text scrolls in its band while the game carries on underneath
   if (!messageDone)
-  {
-    scrollText();
-  }
+    sched.wakeIn(scrollText());
   else
+    comp.setVisible(LAYER_TICKER, false);
+
+  // When this pass draws a generation, the time it was due
+  bool frameDrawn = false;
+  uint32_t frameDue = 0;
+  if (millis() - lastUpdate >= frameMs)
   {
-    if (millis() - lastUpdate >= 333)
-    {
+    frameDrawn = lastUpdate != 0;
+    frameDue = lastUpdate + frameMs;
+    frameMs = frameInterval(drawLifeBoard());
 
-      drawLifeBoard();
+    // A message covers the band (on a 4 x 1 panel, all of it), so the game
+    // neither ends nor runs its end effects until the message has gone
+    if (!advanceLife(messageDone))
+    {
+      // Pattern is stable or oscillating
+#if RECORD_GAMES && !UNBOUNDED_PLANE && !DISTRIBUTED_NODE
+      recorder.end();
+#if SAVE_RECORDINGS
+      recorder.saveFile("/last.lrec");
+#endif
+#endif
+      showEndGameEffect();
+      comp.invalidate(); // The effects draw on the panel directly
+      startNextGame();
+      frameMs = FRAME_MS;
+      frameDrawn = false; // The effects' delays are not latency
+    }
+    lastUpdate = millis();
 
-      if (!life.isGameFinished())
-      {
-        life.computeNextGeneration();
-      }
-      else
-      {
-        // Pattern is stable or oscillating
-        showEndGameEffect();
-        startNextGame();
-      }
-      lastUpdate = millis();
+#if SNAPSHOT_INTERVAL_MS && !UNBOUNDED_PLANE && !DISTRIBUTED_NODE
+    // Spaced out to spare the flash
+    static uint32_t lastSnapshot = 0;
+    if (millis() - lastSnapshot >= SNAPSHOT_INTERVAL_MS)
+    {
+      LifeSnapshot::saveNvs(life, SNAPSHOT_KEY);
+      lastSnapshot = millis();
     }
+#endif
   }
-}
\ No newline at end of file
+  sched.wakeIn(frameMs - (millis() - lastUpdate));
+
+  // Only the rows that changed go out, and nothing at all for a still frame
+  int rows = comp.compose();
+#if LIVE_VIEWER
+  // A quiet panel costs the viewers nothing either, but one that has just
+  // connected gets the current frame straight away
+  if (rows > 0)
+    liveFrame++;
+  if (rows > 0 || viewer.needsKeyframe())
+    viewer.broadcast(comp.getFrame(), liveFrame);
+#endif
+  if (frameDrawn)
+    sched.frameDone(millis() - frameDue, rows > 0);
+  if (firstFrameMs == 0 && lifeDrawn)
+  {
+    firstFrameMs = millis();
+    PRINT("\nFirst frame after ms ", firstFrameMs);
+  }
+
+  // After the display, so the first frame goes out before WiFi starts up
+  networkUp = handleNetwork();
+
+#if POWER_SAVE
+  sched.idle();
+#endif
+}
@@ -0,0 +1,89 @@
+# Gzips everything in web/ into src/WebAssets.h as const arrays, which the
+# ESP32 keeps in flash, each with an ETag taken from its contents.
+#
+# Runs before every PlatformIO build (extra_scripts = pre:tools/webassets.py)
+# and rewrites the header only when an asset changed; it can also be run by
+# hand: python tools/webassets.py
+
+import gzip
+import hashlib
+import os
+import sys
+
+TYPES = {
+    ".html": "text/html",
+    ".js": "application/javascript",
+    ".css": "text/css",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".json": "application/json",
+}
+
+
+def identifier(name):
+    return "asset_" + "".join(c if c.isalnum() else "_" for c in name)
+
+
+def generate(project):
+    web = os.path.join(project, "web")
+    out = os.path.join(project, "src", "WebAssets.h")
+
+    lines = [
+        "// Generated by tools/webassets.py from web/; do not edit",
+        "#pragma once",
+        "#include <stddef.h>",
+        "#include <stdint.h>",
+        "",
+        "struct WebAsset",
+        "{",
+        "    const char *path;",
+        "    const char *type;",
+        "    const char *etag; // Quoted, as sent",
+        "    const uint8_t *data; // Gzipped",
+        "    size_t size;",
+        "};",
+        "",
+    ]
+    entries = []
+    for name in sorted(os.listdir(web)):
+        path = os.path.join(web, name)
+        ext = os.path.splitext(name)[1]
+        if not os.path.isfile(path) or ext not in TYPES:
+            continue
+        with open(path, "rb") as f:
+            raw = f.read()
+        # mtime=0 so an unchanged asset gives the same bytes every build
+        packed = gzip.compress(raw, 9, mtime=0)
+        etag = hashlib.sha1(raw).hexdigest()[:16]
+        ident = identifier(name)
+
+        lines.append("// %s, %d bytes, %d gzipped" % (name, len(raw), len(packed)))
+        lines.append("static const uint8_t %s[] = {" % ident)
+        for i in range(0, len(packed), 16):
+            lines.append("    " + ", ".join("0x%02x" % b for b in packed[i:i + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+        url = "/" if name == "index.html" else "/" + name
+        entries.append('    {"%s", "%s", "\\"%s\\"", %s, sizeof(%s)},' % (url, TYPES[ext], etag, ident, ident))
+
+    lines.append("static const WebAsset webAssets[] = {")
+    lines.extend(entries)
+    lines.append("};")
+    lines.append("static const int WEB_ASSET_COUNT = sizeof(webAssets) / sizeof(webAssets[0]);")
+    text = "\n".join(lines) + "\n"
+
+    old = None
+    if os.path.exists(out):
+        with open(out) as f:
+            old = f.read()
+    if text != old:
+        with open(out, "w") as f:
+            f.write(text)
+        print("webassets: wrote %s (%d assets)" % (os.path.relpath(out, project), len(entries)))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    generate(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    generate(os.path.dirname(os.path.dirname(os.path.abspath(sys.argv[0]))))
@@ -0,0 +1,54 @@
+// Draws the panel from LifeViewer's WebSocket; y = 0 is the bottom row
+var LIVE_PORT = 81; // LIVE_PORT in main.cpp
+
+var cells, boardW, boardH, rowBytes;
+
+// Run-length coded bytes into cells, replacing them or XOR'ed in
+function Runs(b, p, x)
+{
+  function v() { var r = 0, s = 0, c; do { c = b[p++]; r |= (c & 127) << s; s += 7; } while (c & 128); return r; }
+  for (var i = 0; i < cells.length;)
+  {
+    i += v();
+    for (var l = v(); l > 0; l--, i++)
+      cells[i] = x ? cells[i] ^ b[p++] : b[p++];
+  }
+}
+
+function Draw()
+{
+  var c = document.getElementById("live"), g = c.getContext("2d");
+  c.width = boardW * 8; c.height = boardH * 8;
+  g.fillStyle = "#200"; g.fillRect(0, 0, c.width, c.height);
+  g.fillStyle = "#f40";
+  for (var y = 0; y < boardH; y++)
+    for (var x = 0; x < boardW; x++)
+      if (cells[y * rowBytes + (x >> 3)] >> (x & 7) & 1)
+        g.fillRect(x * 8 + 1, (boardH - 1 - y) * 8 + 1, 6, 6);
+}
+
+function Watch()
+{
+  var ws = new WebSocket("ws://" + location.hostname + ":" + LIVE_PORT + "/");
+  var opened = false;
+  ws.binaryType = "arraybuffer";
+  ws.onopen = function() { opened = true; };
+  ws.onmessage = function(e)
+  {
+    var b = new Uint8Array(e.data), d = new DataView(e.data);
+    if (b[0] == 75) // 'K'
+    {
+      boardW = d.getUint16(1, true); boardH = d.getUint16(3, true);
+      rowBytes = Math.ceil(boardW / 64) * 8;
+      cells = new Uint8Array(rowBytes * boardH);
+      Runs(b, 9, false);
+    }
+    else if (cells)
+      Runs(b, 5, true);
+    else
+      return;
+    Draw();
+  };
+  // Reconnect after a drop; a panel built without LIVE_VIEWER never answers
+  ws.onclose = function() { if (opened) setTimeout(Watch, 2000); };
+}